@@ -0,0 +1,118 @@
+#include <jfc/fiber_job_system.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#ifdef JFC_FIBERS_SUPPORTED
+
+using namespace jfc;
+
+/// \brief number of links in each dependency chain
+static constexpr size_t CHAIN_DEPTH = 2000;
+
+/// \brief number of chains run side by side
+static constexpr size_t CHAIN_COUNT = 8;
+
+static constexpr size_t FIBER_STACK_SIZE = 32 * 1024;
+
+static std::chrono::nanoseconds time_since(const std::chrono::steady_clock::time_point start_time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+}
+
+/// \brief each job spawns the next link of its chain and waits for it mid-body, so every link of every chain is suspended at once
+static std::chrono::nanoseconds fiber_chains(thread_group &group)
+{
+    fiber_job_system jobs(group, CHAIN_COUNT * (CHAIN_DEPTH + 1), FIBER_STACK_SIZE);
+
+    std::function<void(size_t)> link = [&](const size_t depth)
+    {
+        if (depth == CHAIN_DEPTH) return;
+
+        fiber_job_system::counter child;
+
+        jobs.run_jobs([&link, depth]() { link(depth + 1); }, &child);
+
+        jobs.wait_for_counter(child);
+    };
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    fiber_job_system::counter roots;
+
+    jobs.run_jobs({CHAIN_COUNT, [&link]() { link(0); }}, &roots);
+
+    jobs.wait_for_counter(roots);
+
+    return time_since(start_time);
+}
+
+/// \brief the same chains split by hand into continuations: each task submits the next and returns
+static std::chrono::nanoseconds continuation_chains(thread_group &group)
+{
+    auto remaining = std::make_shared<std::atomic<size_t>>(CHAIN_COUNT);
+
+    std::function<void(size_t)> link = [&](const size_t depth)
+    {
+        if (depth == CHAIN_DEPTH)
+        {
+            remaining->fetch_sub(1);
+
+            return;
+        }
+
+        group.add_tasks([&link, depth]() { link(depth + 1); });
+    };
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    group.add_tasks({CHAIN_COUNT, [&link]() { link(0); }});
+
+    while (remaining->load())
+    {
+        if (auto task = group.try_get_task()) (*task)();
+    }
+
+    return time_since(start_time);
+}
+
+int main(const int argc, const char **argv)
+{
+    const size_t thread_count = argc > 1
+        ? std::stoul(argv[1])
+        : (std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+
+    thread_group group(thread_count);
+
+    std::cout
+        << CHAIN_COUNT << " chains of " << CHAIN_DEPTH << " dependent jobs\n"
+        << "# of threads in group: " << thread_count << "\n";
+
+    const auto links = static_cast<double>(CHAIN_COUNT * CHAIN_DEPTH);
+
+    const auto fiber_time(fiber_chains(group));
+
+    std::cout << "fibers, waiting mid-body: " << fiber_time.count() / links << " ns per link\n";
+
+    const auto continuation_time(continuation_chains(group));
+
+    std::cout << "hand written continuations: " << continuation_time.count() / links << " ns per link\n";
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main()
+{
+    std::cout << "fibers are not supported on this platform\n";
+
+    return EXIT_SUCCESS;
+}
+
+#endif
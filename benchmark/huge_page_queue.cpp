@@ -0,0 +1,166 @@
+#include <jfc/huge_page_allocator.h>
+#include <jfc/thread_group.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace jfc;
+
+/// \brief counts the data TLB misses of the calling thread, where perf events are available
+class tlb_miss_counter final
+{
+#if defined(__linux__)
+        int m_LoadDescriptor = -1;
+
+        int m_StoreDescriptor = -1;
+
+        static int open(const std::uint64_t operation)
+        {
+            perf_event_attr attributes{};
+
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_DTLB | (operation << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        static std::uint64_t read(const int descriptor)
+        {
+            std::uint64_t count(0);
+
+            if (descriptor >= 0 && ::read(descriptor, &count, sizeof(count)) != sizeof(count)) count = 0;
+
+            return count;
+        }
+
+    public:
+        /// \brief false if the counters could not be opened, e.g. in a virtual machine or under a restrictive perf_event_paranoid
+        bool is_available() const { return m_LoadDescriptor >= 0; }
+
+        void start()
+        {
+            for (const auto descriptor : {m_LoadDescriptor, m_StoreDescriptor}) if (descriptor >= 0)
+            {
+                ::ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        /// \brief stops counting, returns the load and store misses since start
+        std::uint64_t stop()
+        {
+            for (const auto descriptor : {m_LoadDescriptor, m_StoreDescriptor}) if (descriptor >= 0) ::ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+            return read(m_LoadDescriptor) + read(m_StoreDescriptor);
+        }
+
+        tlb_miss_counter()
+        : m_LoadDescriptor(open(PERF_COUNT_HW_CACHE_OP_READ))
+        , m_StoreDescriptor(open(PERF_COUNT_HW_CACHE_OP_WRITE))
+        {}
+
+        tlb_miss_counter(const tlb_miss_counter &) = delete;
+        tlb_miss_counter &operator=(const tlb_miss_counter &) = delete;
+
+        ~tlb_miss_counter()
+        {
+            for (const auto descriptor : {m_LoadDescriptor, m_StoreDescriptor}) if (descriptor >= 0) ::close(descriptor);
+        }
+#else
+    public:
+        bool is_available() const { return false; }
+
+        void start() {}
+
+        std::uint64_t stop() { return 0; }
+#endif
+};
+
+static const char *to_string(const huge_page_region::backing_type backing)
+{
+    switch (backing)
+    {
+        case huge_page_region::backing_type::huge_pages: return "reserved huge pages (MAP_HUGETLB)";
+        case huge_page_region::backing_type::transparent_huge_pages: return "transparent huge pages (MADV_HUGEPAGE)";
+        default: return "normal pages";
+    }
+}
+
+struct queue_result
+{
+    std::chrono::nanoseconds duration;
+
+    std::uint64_t tlb_misses;
+};
+
+/// \brief queues taskCount tasks, so that the queue grows to hold them all at once, then runs them.
+/// the group has no threads, so every queue access, and every TLB miss counted, is on the calling thread
+static queue_result run(const size_t taskCount, const bool useHugePages)
+{
+    thread_group::memory_attributes_type memory;
+    memory.huge_pages = useHugePages;
+
+    thread_group group(0, {}, memory);
+
+    size_t remaining(taskCount);
+
+    tlb_miss_counter counter;
+
+    counter.start();
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    for (size_t i(0); i < taskCount; ++i) group.add_tasks([&remaining]() { --remaining; });
+
+    while (group.run_one());
+
+    const auto duration(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time));
+
+    const auto tlb_misses(counter.stop());
+
+    if (remaining) std::cerr << "not every task ran\n";
+
+    return {duration, tlb_misses};
+}
+
+int main(const int argc, const char **argv)
+{
+    const size_t task_count = argc > 1 ? std::stoul(argv[1]) : 4000000;
+
+    std::cout
+        << task_count << " queued tasks\n"
+        << "a 2 MB region is backed by: " << to_string(huge_page_region(huge_page_region::HUGE_PAGE_SIZE).backing()) << "\n";
+
+    const bool counts_tlb_misses = tlb_miss_counter().is_available();
+
+    if (!counts_tlb_misses) std::cout << "dTLB miss counters are unavailable, see /proc/sys/kernel/perf_event_paranoid\n";
+
+    for (const auto use_huge_pages : {false, true})
+    {
+        const auto result(run(task_count, use_huge_pages));
+
+        std::cout
+            << (use_huge_pages ? "huge pages: " : "heap: ")
+            << static_cast<double>(task_count) / result.duration.count() * 1e9 << " tasks/s";
+
+        if (counts_tlb_misses) std::cout << ", " << result.tlb_misses << " dTLB misses";
+
+        std::cout << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
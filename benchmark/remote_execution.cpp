@@ -0,0 +1,193 @@
+#include <jfc/remote_execution.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef JFC_REMOTE_EXECUTION_SUPPORTED
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace jfc;
+
+/// \brief the functions offered by tools/remote_worker_daemon
+static const remote_function<std::string(std::string)> echo("jfc.echo");
+
+static const remote_function<std::uint32_t(std::uint32_t)> spin_for_us("jfc.spin_for_us");
+
+static constexpr size_t LATENCY_CALL_COUNT = 5000;
+
+static constexpr size_t THROUGHPUT_CALL_COUNT = 100000;
+
+static constexpr size_t PAYLOAD_SIZE = 64;
+
+/// \brief body of the forked worker process, used when no daemon is given: serves the daemon's functions until terminated
+static void serve(const std::string &path)
+{
+    sigset_t signals;
+
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    remote_function_registry registry;
+
+    registry.add(echo, [](const std::string &s) { return s; });
+
+    registry.add(spin_for_us, [](const std::uint32_t us)
+    {
+        const auto end_time(std::chrono::steady_clock::now() + std::chrono::microseconds(us));
+
+        while (std::chrono::steady_clock::now() < end_time);
+
+        return us;
+    });
+
+    thread_group group(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+
+    remote_worker worker(group, std::move(registry), path);
+
+    int signal;
+
+    sigwait(&signals, &signal);
+}
+
+/// \brief round trip time of one call at a time
+static void measure_latency(const std::string &path)
+{
+    remote_executor executor(path);
+
+    const std::string payload(PAYLOAD_SIZE, 'x');
+
+    std::vector<double> latencies;
+
+    latencies.reserve(LATENCY_CALL_COUNT);
+
+    for (size_t i(0); i < LATENCY_CALL_COUNT; ++i)
+    {
+        const auto start_time(std::chrono::steady_clock::now());
+
+        executor.submit(echo, payload).get();
+
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_time).count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout
+        << "round trip of one " << PAYLOAD_SIZE << " byte echo at a time (us)"
+        << " p50: " << latencies[latencies.size() / 2]
+        << ", p99: " << latencies[latencies.size() * 99 / 100]
+        << ", max: " << latencies.back() << "\n";
+}
+
+/// \brief calls per second with many calls outstanding, for a given window and batch size
+static void measure_throughput(const std::string &path, const size_t window, const size_t batchSize)
+{
+    remote_executor executor(path, {window, batchSize});
+
+    const std::string payload(PAYLOAD_SIZE, 'x');
+
+    std::vector<std::future<std::string>> results;
+
+    results.reserve(THROUGHPUT_CALL_COUNT);
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    for (size_t i(0); i < THROUGHPUT_CALL_COUNT; ++i) results.push_back(executor.submit(echo, payload));
+
+    for (auto &result : results) result.get();
+
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::cout << "    window " << window << ", batch " << batchSize << ": " << static_cast<size_t>(THROUGHPUT_CALL_COUNT / seconds) << " calls/s\n";
+}
+
+/// \brief measures remote execution against the daemon listening on the given socket, or against a forked worker process if none is given.
+/// usage: remote_execution_benchmark [socket path of a running remote_worker_daemon]
+int main(const int argc, const char **argv)
+{
+    std::string path;
+
+    pid_t child = 0;
+
+    if (argc > 1) path = argv[1];
+    else
+    {
+        path = "/tmp/jfc-remote_execution_benchmark-" + std::to_string(::getpid());
+
+        std::cout.flush();
+
+        child = ::fork();
+
+        if (child < 0)
+        {
+            std::cerr << "fork failed\n";
+
+            return EXIT_FAILURE;
+        }
+
+        if (!child)
+        {
+            serve(path);
+
+            ::_exit(EXIT_SUCCESS);
+        }
+
+        // wait for the worker to start listening
+        for (;;)
+        {
+            try
+            {
+                remote_executor probe(path);
+
+                break;
+            }
+            catch (const std::system_error &)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+    }
+
+    std::cout << "worker at " << path << "\n";
+
+    measure_latency(path);
+
+    std::cout << "throughput of " << THROUGHPUT_CALL_COUNT << " " << PAYLOAD_SIZE << " byte echoes:\n";
+
+    for (const size_t window : {1, 16, 256, 4096}) measure_throughput(path, window, 256);
+
+    measure_throughput(path, 4096, 1);
+
+    if (child)
+    {
+        ::kill(child, SIGTERM);
+
+        ::waitpid(child, nullptr, 0);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main()
+{
+    std::cout << "remote execution is not supported on this target\n";
+
+    return EXIT_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,152 @@
+#include <jfc/shared_memory_queue.h>
+
+#ifdef JFC_SHARED_MEMORY_SUPPORTED
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace jfc;
+
+static constexpr size_t ITEM_COUNT = 20000;
+
+/// \brief gap between items in the paced run, long enough for the consumer to park before each item
+static constexpr std::chrono::microseconds PACE(100);
+
+/// \brief a work item carrying its send time. steady_clock is CLOCK_MONOTONIC on Linux, which is common to all processes
+struct item_type
+{
+    std::int64_t sent_ns;
+};
+
+using queue_type = shared_memory_queue<item_type, 1024>;
+
+static std::int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/// \brief body of the consumer process: consumes the queue on a thread_group, then prints the latency distribution of the handoffs
+static void consume(const std::string &name, const size_t threadCount)
+{
+    queue_type queue(name, shared_memory_region::open_mode::open);
+
+    std::vector<std::int64_t> latencies;
+
+    latencies.reserve(ITEM_COUNT);
+
+    std::mutex latencies_mutex;
+
+    {
+        thread_group group(threadCount);
+
+        queue.consume(group, [&](const item_type &item)
+        {
+            const auto latency = now_ns() - item.sent_ns;
+
+            std::lock_guard<std::mutex> lock(latencies_mutex);
+
+            latencies.push_back(latency);
+        });
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    auto percentile = [&latencies](const double p)
+    {
+        return latencies.empty() ? 0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))] / 1000.0;
+    };
+
+    std::cout
+        << "    items received: " << latencies.size() << "\n"
+        << "    handoff latency (us) p50: " << percentile(0.5) << ", p90: " << percentile(0.9) << ", p99: " << percentile(0.99) << ", max: " << percentile(1) << "\n";
+}
+
+/// \brief forks a consumer process, then sends it ITEM_COUNT items, each pace after the last
+static void run(const size_t threadCount, const std::chrono::microseconds pace)
+{
+    const auto name = "/jfc-shared_memory_handoff-" + std::to_string(::getpid());
+
+    queue_type queue(name, shared_memory_region::open_mode::create);
+
+    std::cout.flush();
+
+    const auto child = ::fork();
+
+    if (child < 0)
+    {
+        std::cerr << "fork failed\n";
+
+        std::exit(EXIT_FAILURE);
+    }
+
+    if (!child)
+    {
+        consume(name, threadCount);
+
+        std::cout.flush();
+
+        ::_exit(EXIT_SUCCESS);
+    }
+
+    for (size_t i(0); i < ITEM_COUNT; ++i)
+    {
+        if (pace.count())
+        {
+            const auto end_time(std::chrono::steady_clock::now() + pace);
+
+            while (std::chrono::steady_clock::now() < end_time) std::this_thread::yield();
+        }
+
+        queue.enqueue(item_type{now_ns()});
+    }
+
+    // let the consumer drain the ring before closing it
+    while (queue.size_approx()) std::this_thread::yield();
+
+    queue.close();
+
+    ::waitpid(child, nullptr, 0);
+}
+
+int main(const int argc, const char **argv)
+{
+    const size_t thread_count = argc > 1 ? std::stoul(argv[1]) : 1;
+
+    std::cout
+        << "a producer process sends " << ITEM_COUNT << " items through a shared memory queue to a consumer process\n"
+        << "# of threads in consumer's group: " << thread_count << "\n";
+
+    std::cout << "paced, one item every " << PACE.count() << "us (consumers park between items):\n";
+
+    run(thread_count, PACE);
+
+    std::cout << "back to back (consumers rarely park):\n";
+
+    run(thread_count, std::chrono::microseconds(0));
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+#include <cstdlib>
+#include <iostream>
+
+int main()
+{
+    std::cout << "shared memory queues are not supported on this target\n";
+
+    return EXIT_SUCCESS;
+}
+
+#endif
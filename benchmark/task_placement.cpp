@@ -0,0 +1,82 @@
+#include <jfc/thread_group.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace jfc;
+
+/// \brief tasks each producer submits, one add_tasks call per task
+static constexpr size_t TASKS_PER_PRODUCER = 200000;
+
+/// \brief each producer submits its tasks and the workers run them; reports the time from the first submission to the last task completing
+static std::chrono::nanoseconds run(const size_t threadCount, const size_t producerCount, const thread_group::task_placement_mode mode)
+{
+    thread_group group(threadCount);
+
+    group.set_task_placement(mode);
+
+    std::atomic<size_t> remaining(producerCount * TASKS_PER_PRODUCER);
+
+    std::atomic<bool> go(false);
+
+    std::vector<std::thread> producers;
+
+    for (size_t i(0); i < producerCount; ++i) producers.emplace_back([&]()
+    {
+        while (!go.load()) std::this_thread::yield();
+
+        for (size_t j(0); j < TASKS_PER_PRODUCER; ++j) group.add_tasks([&remaining]()
+        {
+            remaining.fetch_sub(1, std::memory_order_relaxed);
+        });
+    });
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    go = true;
+
+    for (auto &producer : producers) producer.join();
+
+    // a group without threads is drained by the caller
+    while (remaining.load(std::memory_order_relaxed))
+    {
+        if (!threadCount) { if (auto task = group.try_get_task()) (*task)(); }
+        else std::this_thread::yield();
+    }
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+}
+
+int main(const int argc, const char **argv)
+{
+    const size_t thread_count = argc > 1
+        ? std::stoul(argv[1])
+        : (std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+
+    const size_t max_producer_count = argc > 2
+        ? std::stoul(argv[2])
+        : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    std::cout
+        << TASKS_PER_PRODUCER << " tasks per producer\n"
+        << "# of threads in group: " << thread_count << "\n"
+        << "producers, shared queue ns/task, two choices ns/task\n";
+
+    for (size_t producer_count(1); producer_count <= max_producer_count; ++producer_count)
+    {
+        const auto tasks = static_cast<double>(producer_count * TASKS_PER_PRODUCER);
+
+        const auto shared_time(run(thread_count, producer_count, thread_group::task_placement_mode::shared_queue));
+        const auto two_choices_time(run(thread_count, producer_count, thread_group::task_placement_mode::two_choices));
+
+        std::cout << producer_count << ", " << shared_time.count() / tasks << ", " << two_choices_time.count() / tasks << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace jfc;
+
+/// \brief tasks submitted by the heavy tenant for every task submitted by the light tenant
+static constexpr size_t SKEW = 20;
+
+static constexpr size_t LIGHT_TASK_COUNT = 500;
+
+static constexpr size_t HEAVY_TASK_COUNT = LIGHT_TASK_COUNT * SKEW;
+
+/// \brief duration of each task's busy work
+static constexpr std::chrono::microseconds TASK_DURATION(20);
+
+static void busy_work()
+{
+    const auto end_time(std::chrono::steady_clock::now() + TASK_DURATION);
+
+    while (std::chrono::steady_clock::now() < end_time);
+}
+
+struct tenant_result
+{
+    std::chrono::nanoseconds light_makespan;
+    std::chrono::nanoseconds heavy_makespan;
+};
+
+/// \brief the heavy tenant floods the group, then the light tenant submits its work.
+/// reports how long it takes each tenant to see all of its tasks completed
+static tenant_result run(const size_t threadCount, const bool useTenants)
+{
+    thread_group group(threadCount);
+
+    const auto heavy_tenant = useTenants ? group.add_tenant() : 0;
+    const auto light_tenant = useTenants ? group.add_tenant() : 0;
+
+    auto light_remaining = std::make_shared<std::atomic<size_t>>(LIGHT_TASK_COUNT);
+    auto heavy_remaining = std::make_shared<std::atomic<size_t>>(HEAVY_TASK_COUNT);
+
+    auto submit = [&](const thread_group::tenant_id_type tenant, std::shared_ptr<std::atomic<size_t>> remaining, const size_t count)
+    {
+        std::vector<thread_group::task_type> tasks(count, [remaining]()
+        {
+            busy_work();
+
+            remaining->fetch_sub(1, std::memory_order_relaxed);
+        });
+
+        if (useTenants) group.add_tasks(tenant, std::move(tasks));
+        else group.add_tasks(std::move(tasks));
+    };
+
+    const auto start_time(std::chrono::steady_clock::now());
+
+    submit(heavy_tenant, heavy_remaining, HEAVY_TASK_COUNT);
+    submit(light_tenant, light_remaining, LIGHT_TASK_COUNT);
+
+    tenant_result result{};
+
+    bool light_done(false), heavy_done(false);
+
+    while (!light_done || !heavy_done)
+    {
+        if (auto task = group.try_get_task()) (*task)();
+
+        const auto now(std::chrono::steady_clock::now());
+
+        if (!light_done && !light_remaining->load(std::memory_order_relaxed))
+        {
+            light_done = true;
+            result.light_makespan = now - start_time;
+        }
+
+        if (!heavy_done && !heavy_remaining->load(std::memory_order_relaxed))
+        {
+            heavy_done = true;
+            result.heavy_makespan = now - start_time;
+        }
+    }
+
+    return result;
+}
+
+int main(const int argc, const char **argv)
+{
+    const size_t thread_count = argc > 1
+        ? std::stoul(argv[1])
+        : (std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0);
+
+    std::cout
+        << "heavy tenant submits " << HEAVY_TASK_COUNT << " tasks, then light tenant submits " << LIGHT_TASK_COUNT << " tasks\n"
+        << "# of threads in group: " << thread_count << "\n";
+
+    for (const bool use_tenants : {false, true})
+    {
+        const auto result(run(thread_count, use_tenants));
+
+        std::cout
+            << (use_tenants ? "weighted fair tenants" : "shared fifo queue") << ":\n"
+            << "    light tenant completes after (ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(result.light_makespan).count() << "\n"
+            << "    heavy tenant completes after (ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(result.heavy_makespan).count() << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+#ifndef JFC_BOUNDED_QUEUE_H
+#define JFC_BOUNDED_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jfc
+{
+    /// \brief fixed capacity lock free multi producer, multi consumer queue.
+    /// storage is held inline, so the queue performs no dynamic allocation. Each cell carries a sequence number recording whether it is ready to be written or read on the current lap of the ring,
+    /// so producers and consumers only contend on their respective position counters.
+    /// \remark all methods are thread friendly
+    /// \remark if T is trivially copyable and std::atomic<size_t> is lock free, the queue is address free and may be placed in memory shared between processes
+    template<class T, size_t capacity_value>
+    class bounded_queue final
+    {
+        static_assert(capacity_value && !(capacity_value & (capacity_value - 1)), "capacity must be a power of two");
+
+        public:
+            /// \brief alias for element type
+            using value_type = T;
+
+            /// \brief get the maximum number of elements the queue can hold
+            static constexpr size_t capacity() { return capacity_value; }
+
+        private:
+            /// \brief assumed size of a cache line, used to keep the position counters from sharing one
+            static constexpr size_t CACHE_LINE_SIZE = 64;
+
+            struct cell_type
+            {
+                /// \brief equal to the cell's position when it is ready to be written, position + 1 when ready to be read
+                std::atomic<size_t> m_Sequence;
+
+                alignas(T) unsigned char m_Storage[sizeof(T)];
+            };
+
+            std::array<cell_type, capacity_value> m_Cells;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_EnqueuePosition;
+
+            alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_DequeuePosition;
+
+        public:
+            /// \brief constructs an element in place at the back of the queue, returns false if the queue is full
+            template<class... argument_types>
+            bool try_emplace(argument_types &&...arguments)
+            {
+                auto position = m_EnqueuePosition.load(std::memory_order_relaxed);
+
+                for (;;)
+                {
+                    auto &cell = m_Cells[position & (capacity_value - 1)];
+
+                    const auto sequence = cell.m_Sequence.load(std::memory_order_acquire);
+
+                    const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+                    if (!difference)
+                    {
+                        if (m_EnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            new (cell.m_Storage) T(std::forward<argument_types>(arguments)...);
+
+                            cell.m_Sequence.store(position + 1, std::memory_order_release);
+
+                            return true;
+                        }
+                    }
+                    else if (difference < 0) return false;
+                    else position = m_EnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            /// \brief adds an element to the back of the queue, returns false if the queue is full
+            bool try_enqueue(T &&value) { return try_emplace(std::move(value)); }
+            /// \overload
+            bool try_enqueue(const T &value) { return try_emplace(value); }
+
+            /// \brief moves the element at the front of the queue into value, returns false if the queue is empty
+            bool try_dequeue(T &value)
+            {
+                auto position = m_DequeuePosition.load(std::memory_order_relaxed);
+
+                for (;;)
+                {
+                    auto &cell = m_Cells[position & (capacity_value - 1)];
+
+                    const auto sequence = cell.m_Sequence.load(std::memory_order_acquire);
+
+                    const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+
+                    if (!difference)
+                    {
+                        if (m_DequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            auto pElement = std::launder(reinterpret_cast<T *>(cell.m_Storage));
+
+                            value = std::move(*pElement);
+
+                            pElement->~T();
+
+                            cell.m_Sequence.store(position + capacity_value, std::memory_order_release);
+
+                            return true;
+                        }
+                    }
+                    else if (difference < 0) return false;
+                    else position = m_DequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            /// \brief get the number of elements in the queue. Exact only when no other thread is using the queue
+            size_t size_approx() const
+            {
+                const auto dequeue_position = m_DequeuePosition.load(std::memory_order_relaxed);
+                const auto enqueue_position = m_EnqueuePosition.load(std::memory_order_relaxed);
+
+                return enqueue_position > dequeue_position ? enqueue_position - dequeue_position : 0;
+            }
+
+            bounded_queue()
+            : m_EnqueuePosition(0)
+            , m_DequeuePosition(0)
+            {
+                for (size_t i(0); i < capacity_value; ++i) m_Cells[i].m_Sequence.store(i, std::memory_order_relaxed);
+            }
+
+            bounded_queue(const bounded_queue &) = delete;
+            bounded_queue &operator=(const bounded_queue &) = delete;
+
+            /// \brief destroys any elements remaining in the queue
+            ~bounded_queue()
+            {
+                if (!std::is_trivially_destructible<T>::value)
+                {
+                    auto position = m_DequeuePosition.load(std::memory_order_relaxed);
+
+                    for (const auto end = m_EnqueuePosition.load(std::memory_order_relaxed); position != end; ++position)
+                    {
+                        std::launder(reinterpret_cast<T *>(m_Cells[position & (capacity_value - 1)].m_Storage))->~T();
+                    }
+                }
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef JFC_CONCURRENCY_CONTROLLER_H
+#define JFC_CONCURRENCY_CONTROLLER_H
+
+#include <jfc/thread_group.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace jfc
+{
+    /// \brief chooses a worker count by hill climbing on measured throughput.
+    /// each step moves the count by one in the current direction. If throughput fell noticeably since the previous step, the direction reverses.
+    /// since the count never settles, the policy keeps probing either side of the optimum and follows it when it moves
+    /// \remark the policy is not thread friendly, it is meant to be owned by a single sampling thread
+    class hill_climbing_policy final
+    {
+        public:
+            /// \brief bounds and sensitivity of the search
+            struct options_type
+            {
+                size_t min_worker_count = 1;
+
+                /// \brief unbounded by default; concurrency_controller caps it at the group's thread count
+                size_t max_worker_count = std::numeric_limits<size_t>::max();
+
+                /// \brief relative change in throughput below which a sample is treated as noise rather than as a fall
+                double noise_threshold = 0.05;
+            };
+
+        private:
+            options_type m_Options;
+
+            /// \brief +1 or -1
+            int m_Direction = 1;
+
+            double m_LastThroughput = 0;
+
+            bool m_HasSample = false;
+
+        public:
+            /// \brief given the worker count during the last sample period and the throughput measured over it, returns the worker count for the next period
+            size_t next_worker_count(size_t currentWorkerCount, double throughput);
+
+            /// \throws std::invalid_argument if min_worker_count exceeds max_worker_count, or noise_threshold is negative
+            hill_climbing_policy(const options_type &options);
+    };
+
+    /// \brief periodically adjusts a thread_group's active worker count to maximise its task completion rate, similar to the .NET thread pool's hill climbing.
+    /// a sampling thread measures completed_task_count over each interval and feeds the rate to a hill_climbing_policy; surplus workers park, see thread_group::set_active_worker_count.
+    /// periods in which no task completed are skipped, since an idle group gives no signal
+    /// \remark the group must outlive the controller. On destruction all of the group's threads are made active again
+    class concurrency_controller final
+    {
+        public:
+            /// \brief alias for the sampling interval
+            using interval_type = std::chrono::steady_clock::duration;
+
+        private:
+            thread_group &m_Group;
+
+            hill_climbing_policy m_Policy;
+
+            const interval_type m_Interval;
+
+            std::mutex m_Mutex;
+
+            /// \brief wakes the sampling thread early when the controller is destroyed
+            std::condition_variable m_StopCondition;
+
+            bool m_IsStopped = false;
+
+            std::thread m_Thread;
+
+            void sample();
+
+        public:
+            /// \brief starts controlling the group. The search is bounded by options, whose max_worker_count is capped at the group's thread count
+            /// \throws std::invalid_argument if the options are invalid, or the group has no threads
+            concurrency_controller(thread_group &group, hill_climbing_policy::options_type options, interval_type interval = std::chrono::milliseconds(100));
+
+            concurrency_controller(const concurrency_controller &) = delete;
+            concurrency_controller &operator=(const concurrency_controller &) = delete;
+
+            ~concurrency_controller();
+    };
+}
+
+#endif
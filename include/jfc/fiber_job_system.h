@@ -0,0 +1,97 @@
+#ifndef JFC_FIBER_JOB_SYSTEM_H
+#define JFC_FIBER_JOB_SYSTEM_H
+
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/// \brief defined if the fiber layer is available on the target: it relies on a hand written context switch, provided for x86-64 and AArch64 Linux
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define JFC_FIBERS_SUPPORTED
+#endif
+
+#ifdef JFC_FIBERS_SUPPORTED
+
+namespace jfc
+{
+    /// \brief stackful job layer built on a thread_group.
+    /// each job runs on a fiber: a small stack of its own, taken from a fixed pool. A job may wait on a counter partway through its body;
+    /// its fiber is then suspended and the worker goes on to run other tasks, until the counter is reached and the fiber is resumed, possibly on another worker.
+    /// \remark all methods are thread friendly
+    /// \warning jobs must not throw. A job resumed after waiting may be on a different thread than before, so thread_local state must not be held across wait_for_counter
+    class fiber_job_system final
+    {
+        public:
+            /// \brief alias for job functor
+            using job_type = std::function<void()>;
+
+        private:
+            struct shared_data_type;
+
+            struct fiber_type;
+
+        public:
+            /// \brief counts outstanding jobs. Incremented when jobs are submitted against it, decremented as each completes
+            class counter final
+            {
+                friend class fiber_job_system;
+
+                /// \brief a fiber waiting for the counter to reach a value
+                using waiter_type = std::pair<fiber_type *, size_t>;
+
+                std::atomic<size_t> m_Value;
+
+                /// \brief guards m_Waiters. Waiters are registered and released under the lock so that none is missed
+                std::mutex m_Mutex;
+
+                std::vector<waiter_type> m_Waiters;
+
+            public:
+                /// \brief get the current value
+                size_t value() const;
+
+                counter(size_t value = 0);
+
+                counter(const counter &) = delete;
+                counter &operator=(const counter &) = delete;
+            };
+
+        private:
+            /// \brief shared data is stored in a shared_ptr so it lives until the last task referring to a fiber has run
+            std::shared_ptr<shared_data_type> m_SharedData;
+
+        public:
+            /// \brief adds a collection of jobs, incrementing the counter (if any) by the number of jobs. Each completed job decrements it.
+            void run_jobs(std::vector<job_type> &&jobs, counter *pCounter = nullptr);
+            /// \overload
+            void run_jobs(job_type &&job, counter *pCounter = nullptr);
+
+            /// \brief waits until the counter is at or below value.
+            /// if called from a job, the job's fiber is suspended and the worker is free to run other work in the meantime.
+            /// otherwise the calling thread helps the group with its tasks until the counter is reached
+            void wait_for_counter(counter &c, size_t value = 0);
+
+            /// \brief get the number of fibers in the pool
+            size_t fiber_count() const;
+
+            /// \brief constructs a job system running on group, with a pool of fiberCount fibers each with a stack of stackSize bytes
+            /// \warning group must outlive the job system, and all jobs must have completed before the job system is destroyed
+            /// \warning a job holds its fiber until it completes, including while it waits. A job that finds no free fiber is requeued until one is released, so jobs waiting on each other must never need more than fiberCount fibers at once:
+            /// a chain of jobs each waiting on the next deeper than fiberCount never completes
+            fiber_job_system(thread_group &group, size_t fiberCount = 128, size_t stackSize = 64 * 1024);
+
+            fiber_job_system(const fiber_job_system &) = delete;
+            fiber_job_system &operator=(const fiber_job_system &) = delete;
+
+            ~fiber_job_system();
+    };
+}
+
+#endif
+
+#endif
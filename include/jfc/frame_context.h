@@ -0,0 +1,132 @@
+#ifndef JFC_FRAME_CONTEXT_H
+#define JFC_FRAME_CONTEXT_H
+
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jfc
+{
+    /// \brief frame scoped task submission for a thread_group.
+    /// task closures and the data tasks produce are allocated from a linear arena rather than the general purpose allocator;
+    /// the arena is reset in O(1) by end_frame, once all of the frame's tasks have completed.
+    /// \remark all methods but end_frame are thread friendly, and may be called from within the frame's tasks
+    class frame_context final
+    {
+        public:
+            /// \brief adds a task to the group, storing its closure in the arena. The closure is destroyed once run.
+            /// an exception thrown by the task propagates to the thread running it, as with other group tasks, but the task still counts as completed
+            /// \throws std::bad_alloc if the arena is exhausted
+            template<class task_functor_type>
+            void add_task(task_functor_type &&task);
+
+            /// \brief allocates and value initializes count objects of type T in the arena. The storage is valid until end_frame
+            /// \throws std::bad_alloc if the arena is exhausted
+            template<class T>
+            T *allocate(size_t count = 1);
+
+            /// \brief allocates size bytes aligned to alignment from the arena
+            /// \throws std::bad_alloc if the arena is exhausted
+            void *allocate_bytes(size_t size, size_t alignment = alignof(std::max_align_t));
+
+            /// \brief ends the frame: helps the group run tasks until every task added this frame has completed, then resets the arena.
+            /// the calling thread works rather than waits. It takes whatever task the group offers, not only the frame's, so a long task from another submitter can delay the end of the frame
+            /// \throws whatever a task run by the calling thread throws, leaving the frame open; calling end_frame again resumes it
+            /// \warning must not be called from a task, nor concurrently with add_task or allocate
+            void end_frame();
+
+            /// \brief get the number of tasks added this frame that have not yet completed
+            size_t outstanding_task_count() const;
+
+            /// \brief get the number of arena bytes used this frame
+            size_t bytes_used() const;
+
+            /// \brief get the size of the arena in bytes
+            size_t capacity() const;
+
+            /// \brief constructs a frame context submitting to group, with an arena of arenaSize bytes
+            frame_context(thread_group &group, size_t arenaSize = 1024 * 1024);
+
+            frame_context(const frame_context &) = delete;
+            frame_context &operator=(const frame_context &) = delete;
+
+            /// \brief ends the current frame, so that no task refers to the arena once it is freed
+            ~frame_context();
+
+        private:
+            /// \brief the start of every closure stored in the arena: what the group task needs to run it
+            struct task_node_header_type
+            {
+                frame_context *m_pContext;
+
+                void (*m_pRun)(void *);
+            };
+
+            /// \brief closure stored in the arena, invoked through a plain function pointer
+            template<class task_functor_type>
+            struct task_node_type
+            {
+                task_node_header_type m_Header;
+
+                task_functor_type m_Task;
+
+                static void run(void *pNode)
+                {
+                    auto &node = *static_cast<task_node_type *>(pNode);
+
+                    // the closure is destroyed even if the task throws
+                    struct destroy_guard
+                    {
+                        task_node_type &m_Node;
+
+                        ~destroy_guard() { m_Node.~task_node_type(); }
+                    } guard{node};
+
+                    node.m_Task();
+                }
+            };
+
+            /// \brief submits the arena stored closure as a group task. The task holds only a pointer to the node, so it fits std::function's small buffer and submission does not allocate
+            void submit(task_node_header_type *pNode);
+
+            thread_group &m_Group;
+
+            std::unique_ptr<unsigned char[]> m_Arena;
+
+            size_t m_Capacity;
+
+            /// \brief bump pointer, as an offset into the arena
+            std::atomic<size_t> m_Offset;
+
+            std::atomic<size_t> m_OutstandingTaskCount;
+    };
+
+    template<class task_functor_type>
+    void frame_context::add_task(task_functor_type &&task)
+    {
+        using node_type = task_node_type<typename std::decay<task_functor_type>::type>;
+
+        auto pNode = new (allocate_bytes(sizeof(node_type), alignof(node_type))) node_type{{this, &node_type::run}, std::forward<task_functor_type>(task)};
+
+        submit(&pNode->m_Header);
+    }
+
+    template<class T>
+    T *frame_context::allocate(const size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "arena storage is released without running destructors");
+
+        auto pStorage = static_cast<T *>(allocate_bytes(sizeof(T) * count, alignof(T)));
+
+        for (size_t i(0); i < count; ++i) new (pStorage + i) T();
+
+        return pStorage;
+    }
+}
+
+#endif
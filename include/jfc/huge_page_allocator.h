@@ -0,0 +1,135 @@
+#ifndef JFC_HUGE_PAGE_ALLOCATOR_H
+#define JFC_HUGE_PAGE_ALLOCATOR_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace jfc
+{
+    /// \brief anonymous memory mapped with 2 MB pages where the system allows, so that large working sets, e.g. millions of queued tasks, need far fewer TLB entries.
+    /// explicit huge pages (MAP_HUGETLB) are tried first. They require pages reserved by the administrator (vm.nr_hugepages), so the region falls back to transparent huge pages (madvise(MADV_HUGEPAGE)) on 2 MB aligned memory, then to normal pages
+    /// \remark outside Linux the region is always backed by normal pages
+    class huge_page_region final
+    {
+        public:
+            /// \brief the size of a huge page, regions are a multiple of it
+            static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+            /// \brief what the region's memory is backed by
+            enum class backing_type
+            {
+                /// \brief reserved huge pages, MAP_HUGETLB
+                huge_pages,
+
+                /// \brief 2 MB aligned memory the kernel was advised to back with transparent huge pages. Whether it does depends on /sys/kernel/mm/transparent_hugepage and on fragmentation
+                transparent_huge_pages,
+
+                /// \brief normal pages
+                normal_pages
+            };
+
+        private:
+            void *m_pAddress = nullptr;
+
+            size_t m_Size;
+
+            backing_type m_Backing = backing_type::normal_pages;
+
+        public:
+            /// \brief get the address of the region, aligned to HUGE_PAGE_SIZE
+            void *data() const { return m_pAddress; }
+
+            /// \brief get the size of the region in bytes
+            size_t size() const { return m_Size; }
+
+            /// \brief get what the region is backed by
+            backing_type backing() const { return m_Backing; }
+
+            /// \brief maps at least size bytes, rounded up to a multiple of HUGE_PAGE_SIZE. The memory starts zeroed
+            /// \throws std::bad_alloc if no memory could be mapped
+            huge_page_region(size_t size);
+
+            huge_page_region(const huge_page_region &) = delete;
+            huge_page_region &operator=(const huge_page_region &) = delete;
+
+            ~huge_page_region();
+    };
+
+    /// \brief bump pointer arena over huge_page_regions, for memory that lives as long as the arena, e.g. the blocks of a thread_group's queues.
+    /// the arena grows a region at a time; freeing costs nothing and memory is returned only when the arena is destroyed
+    /// \remark all methods are thread friendly. Allocation takes a lock, so suits allocations that are few and large rather than per task
+    class huge_page_arena final
+    {
+            mutable std::mutex m_Mutex;
+
+            std::vector<std::unique_ptr<huge_page_region>> m_Regions;
+
+            /// \brief bytes used of the last region
+            size_t m_Offset = 0;
+
+        public:
+            /// \brief returns size bytes aligned to alignment (a power of two no greater than a huge page), or nullptr if no further region could be mapped
+            void *try_allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+            /// \brief get the number of bytes mapped by the arena
+            size_t capacity() const;
+
+            /// \brief get what the arena's regions are backed by: the weakest backing of any of them, normal_pages if there are none
+            huge_page_region::backing_type backing() const;
+
+            huge_page_arena() = default;
+
+            huge_page_arena(const huge_page_arena &) = delete;
+            huge_page_arena &operator=(const huge_page_arena &) = delete;
+    };
+
+    /// \brief standard allocator drawing from a huge_page_arena, e.g. for task data built once and read by many tasks.
+    /// \code
+    /// jfc::huge_page_arena arena;
+    /// std::vector<float, jfc::huge_page_allocator<float>> samples(1 << 24, 0.f, jfc::huge_page_allocator<float>(&arena));
+    /// \endcode
+    /// \warning deallocation is a no-op, memory is reclaimed when the arena is destroyed; the arena must outlive every container using it
+    template<class T>
+    class huge_page_allocator
+    {
+        huge_page_arena *m_pArena;
+
+        public:
+            using value_type = T;
+
+            /// \brief get the arena drawn from
+            huge_page_arena *arena() const noexcept { return m_pArena; }
+
+            T *allocate(const size_t count)
+            {
+                if (count > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+
+                if (auto p = m_pArena->try_allocate(count * sizeof(T), alignof(T))) return static_cast<T *>(p);
+
+                throw std::bad_alloc();
+            }
+
+            void deallocate(T *, size_t) noexcept {}
+
+            explicit huge_page_allocator(huge_page_arena *const pArena) noexcept
+            : m_pArena(pArena)
+            {}
+
+            template<class U>
+            huge_page_allocator(const huge_page_allocator<U> &b) noexcept
+            : m_pArena(b.arena())
+            {}
+    };
+
+    template<class T, class U>
+    bool operator==(const huge_page_allocator<T> &a, const huge_page_allocator<U> &b) noexcept { return a.arena() == b.arena(); }
+
+    template<class T, class U>
+    bool operator!=(const huge_page_allocator<T> &a, const huge_page_allocator<U> &b) noexcept { return a.arena() != b.arena(); }
+}
+
+#endif
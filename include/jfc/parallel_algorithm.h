@@ -0,0 +1,306 @@
+#ifndef JFC_PARALLEL_ALGORITHM_H
+#define JFC_PARALLEL_ALGORITHM_H
+
+#include <jfc/thread_group.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jfc::execution
+{
+    /// \brief execution policy running standard style algorithms on a thread_group, see par_on.
+    /// the overloads below take the policy as their first argument, as the std parallel algorithms do, and are found by argument dependent lookup:
+    /// \code
+    /// for_each(jfc::execution::par_on(group), values.begin(), values.end(), f);
+    /// \endcode
+    /// the range is split into chunks run as tasks on the group. The calling thread helps with the group's tasks until every chunk has run,
+    /// so the algorithms may be called from within a task, or on a group with no threads.
+    /// if an element access function throws, the remaining chunks still run and the first exception is rethrown by the algorithm, rather than std::terminate being called.
+    /// ranges that are not random access are processed sequentially by the calling thread
+    class thread_group_policy final
+    {
+            thread_group *m_pGroup;
+
+            size_t m_GrainSize;
+
+        public:
+            /// \brief get the group the algorithms run on
+            thread_group &group() const { return *m_pGroup; }
+
+            /// \brief get the smallest number of elements given to a task
+            size_t grain_size() const { return m_GrainSize; }
+
+            /// \brief returns a copy of the policy that gives each task at least grainSize elements, to amortise the cost of a task over cheap elements
+            thread_group_policy with_grain_size(const size_t grainSize) const
+            {
+                auto policy = *this;
+
+                policy.m_GrainSize = std::max<size_t>(grainSize, 1);
+
+                return policy;
+            }
+
+            thread_group_policy(thread_group &group)
+            : m_pGroup(&group)
+            , m_GrainSize(1)
+            {}
+    };
+
+    /// \brief returns a policy that runs algorithms on group
+    inline thread_group_policy par_on(thread_group &group)
+    {
+        return thread_group_policy(group);
+    }
+
+    namespace detail
+    {
+        template<class iterator_type>
+        using is_random_access = std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<iterator_type>::iterator_category>;
+
+        /// \brief number of chunks per thread, so that threads finishing early can take more work
+        static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+        /// \brief returns how many chunks to split count elements into
+        inline size_t chunk_count(const thread_group_policy &policy, const size_t count)
+        {
+            const auto by_threads = (policy.group().thread_count() + 1) * CHUNKS_PER_THREAD;
+
+            const auto by_grain = (count + policy.grain_size() - 1) / policy.grain_size();
+
+            return std::max<size_t>(std::min(by_threads, by_grain), 1);
+        }
+
+        /// \brief calls f(chunk, begin, end) for each of chunks even slices of [0, count) on the group, returning once all have run
+        template<class functor_type>
+        void parallel_for_chunks(const thread_group_policy &policy, const size_t count, const size_t chunks, const functor_type &f)
+        {
+            if (!count) return;
+
+            std::atomic<size_t> remaining(chunks);
+
+            std::exception_ptr first_exception;
+
+            std::mutex exception_mutex;
+
+            auto &group = policy.group();
+
+            std::vector<thread_group::task_type> tasks;
+
+            tasks.reserve(chunks);
+
+            for (size_t chunk(0); chunk < chunks; ++chunk)
+            {
+                tasks.push_back([&, chunk]()
+                {
+                    try
+                    {
+                        f(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(exception_mutex);
+
+                        if (!first_exception) first_exception = std::current_exception();
+                    }
+
+                    remaining.fetch_sub(1, std::memory_order_release);
+                });
+            }
+
+            group.add_tasks(std::move(tasks));
+
+            while (remaining.load(std::memory_order_acquire))
+            {
+                if (auto task = group.try_get_task()) (*task)();
+                else std::this_thread::yield();
+            }
+
+            if (first_exception) std::rethrow_exception(first_exception);
+        }
+    }
+
+    /// \brief parallel std::for_each
+    template<class iterator_type, class functor_type>
+    void for_each(const thread_group_policy &policy, iterator_type first, iterator_type last, functor_type f)
+    {
+        if constexpr (detail::is_random_access<iterator_type>::value)
+        {
+            const size_t count = std::distance(first, last);
+
+            detail::parallel_for_chunks(policy, count, detail::chunk_count(policy, count), [&](size_t, const size_t begin, const size_t end)
+            {
+                std::for_each(first + begin, first + end, f);
+            });
+        }
+        else std::for_each(first, last, f);
+    }
+
+    /// \brief parallel std::transform
+    template<class input_iterator_type, class output_iterator_type, class functor_type>
+    output_iterator_type transform(const thread_group_policy &policy, input_iterator_type first, input_iterator_type last, output_iterator_type d_first, functor_type op)
+    {
+        if constexpr (detail::is_random_access<input_iterator_type>::value && detail::is_random_access<output_iterator_type>::value)
+        {
+            const size_t count = std::distance(first, last);
+
+            detail::parallel_for_chunks(policy, count, detail::chunk_count(policy, count), [&](size_t, const size_t begin, const size_t end)
+            {
+                std::transform(first + begin, first + end, d_first + begin, op);
+            });
+
+            return d_first + count;
+        }
+        else return std::transform(first, last, d_first, op);
+    }
+    /// \overload
+    template<class input_iterator_type, class input_iterator_2_type, class output_iterator_type, class functor_type>
+    output_iterator_type transform(const thread_group_policy &policy, input_iterator_type first1, input_iterator_type last1, input_iterator_2_type first2, output_iterator_type d_first, functor_type op)
+    {
+        if constexpr (detail::is_random_access<input_iterator_type>::value && detail::is_random_access<input_iterator_2_type>::value && detail::is_random_access<output_iterator_type>::value)
+        {
+            const size_t count = std::distance(first1, last1);
+
+            detail::parallel_for_chunks(policy, count, detail::chunk_count(policy, count), [&](size_t, const size_t begin, const size_t end)
+            {
+                std::transform(first1 + begin, first1 + end, first2 + begin, d_first + begin, op);
+            });
+
+            return d_first + count;
+        }
+        else return std::transform(first1, last1, first2, d_first, op);
+    }
+
+    /// \brief parallel std::reduce. Each chunk is reduced separately, then the partial results are combined with init in order, so op must be associative
+    template<class iterator_type, class value_type, class functor_type>
+    value_type reduce(const thread_group_policy &policy, iterator_type first, iterator_type last, value_type init, functor_type op)
+    {
+        if constexpr (detail::is_random_access<iterator_type>::value)
+        {
+            const size_t count = std::distance(first, last);
+
+            const auto chunks = detail::chunk_count(policy, count);
+
+            std::vector<std::optional<value_type>> partials(chunks);
+
+            detail::parallel_for_chunks(policy, count, chunks, [&](const size_t chunk, const size_t begin, const size_t end)
+            {
+                if (begin == end) return;
+
+                value_type partial = first[begin];
+
+                for (auto i = begin + 1; i < end; ++i) partial = op(std::move(partial), first[i]);
+
+                partials[chunk] = std::move(partial);
+            });
+
+            for (auto &partial : partials) if (partial) init = op(std::move(init), std::move(*partial));
+
+            return init;
+        }
+        else return std::accumulate(first, last, std::move(init), op);
+    }
+    /// \overload
+    template<class iterator_type, class value_type>
+    value_type reduce(const thread_group_policy &policy, iterator_type first, iterator_type last, value_type init)
+    {
+        return reduce(policy, first, last, std::move(init), std::plus<>());
+    }
+    /// \overload
+    template<class iterator_type>
+    typename std::iterator_traits<iterator_type>::value_type reduce(const thread_group_policy &policy, iterator_type first, iterator_type last)
+    {
+        return reduce(policy, first, last, typename std::iterator_traits<iterator_type>::value_type{}, std::plus<>());
+    }
+
+    /// \brief parallel std::sort: chunks are sorted in parallel, then merged pairwise in parallel rounds. Like std::sort, the sort is not stable
+    template<class iterator_type, class comparator_type>
+    void sort(const thread_group_policy &policy, iterator_type first, iterator_type last, comparator_type comp)
+    {
+        static_assert(detail::is_random_access<iterator_type>::value, "sort requires random access iterators");
+
+        const size_t count = std::distance(first, last);
+
+        const auto runs = detail::chunk_count(policy, count);
+
+        // sorted runs are [bounds[r], bounds[r + 1])
+        std::vector<size_t> bounds(runs + 1);
+
+        for (size_t run(0); run <= runs; ++run) bounds[run] = count * run / runs;
+
+        detail::parallel_for_chunks(policy, count, runs, [&](size_t, const size_t begin, const size_t end)
+        {
+            std::sort(first + begin, first + end, comp);
+        });
+
+        while (bounds.size() > 2)
+        {
+            const auto pairs = (bounds.size() - 1) / 2;
+
+            detail::parallel_for_chunks(policy, pairs, pairs, [&](const size_t pair, size_t, size_t)
+            {
+                std::inplace_merge(first + bounds[2 * pair], first + bounds[2 * pair + 1], first + bounds[2 * pair + 2], comp);
+            });
+
+            // an odd run out is carried into the next round unmerged
+            std::vector<size_t> merged_bounds;
+
+            for (size_t i(0); i < bounds.size(); i += 2) merged_bounds.push_back(bounds[i]);
+
+            if (merged_bounds.back() != count) merged_bounds.push_back(count);
+
+            bounds = std::move(merged_bounds);
+        }
+    }
+    /// \overload
+    template<class iterator_type>
+    void sort(const thread_group_policy &policy, iterator_type first, iterator_type last)
+    {
+        sort(policy, first, last, std::less<>());
+    }
+
+    /// \brief parallel std::fill
+    template<class iterator_type, class value_type>
+    void fill(const thread_group_policy &policy, iterator_type first, iterator_type last, const value_type &value)
+    {
+        if constexpr (detail::is_random_access<iterator_type>::value)
+        {
+            const size_t count = std::distance(first, last);
+
+            detail::parallel_for_chunks(policy, count, detail::chunk_count(policy, count), [&](size_t, const size_t begin, const size_t end)
+            {
+                std::fill(first + begin, first + end, value);
+            });
+        }
+        else std::fill(first, last, value);
+    }
+
+    /// \brief parallel std::copy
+    template<class input_iterator_type, class output_iterator_type>
+    output_iterator_type copy(const thread_group_policy &policy, input_iterator_type first, input_iterator_type last, output_iterator_type d_first)
+    {
+        if constexpr (detail::is_random_access<input_iterator_type>::value && detail::is_random_access<output_iterator_type>::value)
+        {
+            const size_t count = std::distance(first, last);
+
+            detail::parallel_for_chunks(policy, count, detail::chunk_count(policy, count), [&](size_t, const size_t begin, const size_t end)
+            {
+                std::copy(first + begin, first + end, d_first + begin);
+            });
+
+            return d_first + count;
+        }
+        else return std::copy(first, last, d_first);
+    }
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef JFC_REMOTE_EXECUTION_H
+#define JFC_REMOTE_EXECUTION_H
+
+#include <jfc/thread_group.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+/// \brief defined if remote execution is available on the target: it relies on Unix domain sockets
+#if defined(__linux__)
+#define JFC_REMOTE_EXECUTION_SUPPORTED
+#endif
+
+#ifdef JFC_REMOTE_EXECUTION_SUPPORTED
+
+namespace jfc
+{
+    /// \brief converts values to and from the bytes sent to remote workers.
+    /// provided for trivially copyable types, copied as is, and for std::string. Specialise it with the same static encode and decode to send other types
+    /// \warning values are copied in host byte order and layout, so both ends must be built for the same target
+    template<class T, class = void>
+    struct remote_codec;
+
+    template<class T>
+    struct remote_codec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+    {
+        static std::string encode(const T &value)
+        {
+            return std::string(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        /// \throws std::runtime_error if bytes is not the size of a T
+        static T decode(const std::string &bytes)
+        {
+            if (bytes.size() != sizeof(T)) throw std::runtime_error("jfc::remote_codec: payload is the wrong size for its type");
+
+            T value;
+
+            std::memcpy(&value, bytes.data(), sizeof(T));
+
+            return value;
+        }
+    };
+
+    template<>
+    struct remote_codec<std::string>
+    {
+        static std::string encode(const std::string &value) { return value; }
+
+        static std::string decode(const std::string &bytes) { return bytes; }
+    };
+
+    /// \brief names a function that remote workers can run, typed by its signature, e.g. remote_function<int(int)>("square").
+    /// the name is all that is sent: the client and the worker each construct the function from the same name and signature
+    template<class signature_type>
+    class remote_function;
+
+    template<class result_type, class argument_type>
+    class remote_function<result_type(argument_type)> final
+    {
+            std::string m_Name;
+
+            std::uint32_t m_Id;
+
+        public:
+            /// \brief get the name of the function
+            const std::string &name() const { return m_Name; }
+
+            /// \brief get the identifier sent on the wire, a hash of the name
+            std::uint32_t id() const { return m_Id; }
+
+            explicit remote_function(std::string name)
+            : m_Name(std::move(name))
+            {
+                // FNV-1a, so that ids are stable across builds and processes
+                m_Id = 2166136261u;
+
+                for (const auto c : m_Name) m_Id = (m_Id ^ static_cast<unsigned char>(c)) * 16777619u;
+            }
+    };
+
+    /// \brief the functions a remote_worker can run, by id
+    class remote_function_registry final
+    {
+        public:
+            /// \brief alias for a function working on encoded arguments and results
+            using handler_type = std::function<std::string(const std::string &)>;
+
+        private:
+            std::unordered_map<std::uint32_t, handler_type> m_Handlers;
+
+        public:
+            /// \brief makes f available to clients calling function
+            /// \throws std::invalid_argument if a function with the same id is already registered
+            template<class result_type, class argument_type, class functor_type>
+            void add(const remote_function<result_type(argument_type)> &function, functor_type f)
+            {
+                static_assert(!std::is_void<result_type>::value, "remote functions must return a value");
+
+                if (!m_Handlers.emplace(function.id(), [f = std::move(f)](const std::string &bytes)
+                {
+                    return remote_codec<result_type>::encode(f(remote_codec<argument_type>::decode(bytes)));
+                }).second) throw std::invalid_argument("jfc::remote_function_registry: " + function.name() + " collides with a registered function");
+            }
+
+            /// \brief returns the handler for id, nullptr if there is none
+            const handler_type *find(const std::uint32_t id) const
+            {
+                const auto it = m_Handlers.find(id);
+
+                return it != m_Handlers.end() ? &it->second : nullptr;
+            }
+    };
+
+    /// \brief serves remote_executor clients over a Unix domain socket, running their requests as tasks on a thread_group.
+    /// requests arrive in batches; the responses of a connection are sent back in batches as tasks finish, so many small requests share each system call.
+    /// each connection runs at most max_in_flight requests at a time and stops reading past that, so a client that ignores its window is held back by the socket rather than by unbounded memory.
+    /// \remark the group must outlive the worker. The socket file is removed on destruction
+    class remote_worker final
+    {
+        public:
+            struct options_type
+            {
+                /// \brief most requests of one connection that may be queued or running at a time
+                size_t max_in_flight = 1024;
+            };
+
+        private:
+            struct shared_data_type;
+
+            std::shared_ptr<shared_data_type> m_SharedData;
+
+        public:
+            /// \brief get the path of the socket
+            const std::string &socket_path() const;
+
+            /// \brief get the number of requests run so far
+            size_t completed_request_count() const;
+
+            /// \brief starts listening on socketPath, which must not exist
+            /// \throws std::system_error if the socket cannot be bound
+            remote_worker(thread_group &group, remote_function_registry registry, std::string socketPath, options_type options);
+            /// \overload
+            remote_worker(thread_group &group, remote_function_registry registry, std::string socketPath);
+
+            remote_worker(const remote_worker &) = delete;
+            remote_worker &operator=(const remote_worker &) = delete;
+
+            /// \brief stops accepting, closes connections and waits for their requests to finish
+            ~remote_worker();
+    };
+
+    /// \brief client offloading remote_function calls to a remote_worker.
+    /// submitted calls are batched: a sender thread writes every call submitted since its last write as one frame, up to max_batch_size calls or 64 MiB, whichever comes first.
+    /// flow control is a credit window: at most max_in_flight calls may be awaiting results, further submissions block until results return.
+    /// if a remote function throws, or is unknown to the worker, its future holds a std::runtime_error. If the connection is lost, all pending futures hold one
+    /// \remark all methods are thread friendly
+    class remote_executor final
+    {
+        public:
+            /// \brief largest encoded argument of a call, and largest encoded result a worker sends back. Frames are limited to 64 MiB so that a malformed one cannot claim unbounded memory, and a record's header takes 16 bytes of that
+            static constexpr size_t MAX_PAYLOAD_SIZE = 64 * 1024 * 1024 - 16;
+
+            struct options_type
+            {
+                /// \brief most calls that may be awaiting results at a time
+                size_t max_in_flight = 1024;
+
+                /// \brief most calls written in one frame. A batch is also cut short where the next call would take the frame past 64 MiB
+                size_t max_batch_size = 256;
+            };
+
+            /// \brief alias for the completion of a call: true and the encoded result, or false and an error message
+            using completion_type = std::function<void(bool, std::string)>;
+
+        private:
+            struct shared_data_type;
+
+            std::shared_ptr<shared_data_type> m_SharedData;
+
+            /// \brief queues an encoded call, blocking while the window is full
+            void submit_encoded(std::uint32_t functionId, std::string argument, completion_type completion);
+
+        public:
+            /// \brief calls function with argument on the worker. A result encoded larger than MAX_PAYLOAD_SIZE fails the call with a std::runtime_error
+            /// \throws std::runtime_error if the connection has been lost
+            /// \throws std::invalid_argument if the encoded argument is larger than MAX_PAYLOAD_SIZE
+            template<class result_type, class argument_type>
+            std::future<result_type> submit(const remote_function<result_type(argument_type)> &function, const argument_type &argument)
+            {
+                auto pPromise = std::make_shared<std::promise<result_type>>();
+
+                auto future = pPromise->get_future();
+
+                submit_encoded(function.id(), remote_codec<argument_type>::encode(argument), [pPromise, name = function.name()](const bool succeeded, std::string bytes)
+                {
+                    try
+                    {
+                        if (!succeeded) throw std::runtime_error("jfc::remote_executor: " + name + " failed: " + bytes);
+
+                        pPromise->set_value(remote_codec<result_type>::decode(bytes));
+                    }
+                    catch (...)
+                    {
+                        pPromise->set_exception(std::current_exception());
+                    }
+                });
+
+                return future;
+            }
+
+            /// \brief get the number of calls awaiting results
+            size_t in_flight_count() const;
+
+            /// \brief connects to the worker listening on socketPath
+            /// \throws std::system_error if the connection fails
+            /// \throws std::invalid_argument if either option is zero
+            remote_executor(const std::string &socketPath, options_type options);
+            /// \overload
+            remote_executor(const std::string &socketPath);
+
+            remote_executor(const remote_executor &) = delete;
+            remote_executor &operator=(const remote_executor &) = delete;
+
+            /// \brief disconnects. Calls still awaiting results fail
+            ~remote_executor();
+    };
+}
+
+#endif
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef JFC_SCRATCH_ARENA_H
+#define JFC_SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+
+namespace jfc
+{
+    /// \brief bump pointer arena for temporaries that die with the task that made them.
+    /// every worker of a thread_group owns one, made current for the duration of each task and reset by the worker loop after each task returns,
+    /// so allocating from it costs a pointer bump and freeing costs nothing. Use it via scratch_allocator, or directly via current().
+    /// \warning memory from a worker's arena must not outlive the task that allocated it, nor be held by a fiber job across wait_for_counter, since the fiber may resume after the task has ended
+    /// \remark an arena is used only by the thread on which it is current, so it is not synchronized
+    class scratch_arena final
+    {
+            /// \brief the storage if owned by the arena, allocated on first use so that idle workers cost no memory
+            std::unique_ptr<unsigned char[]> m_Buffer;
+
+            /// \brief the storage, owned or not, nullptr until first use
+            unsigned char *m_pData = nullptr;
+
+            size_t m_Capacity;
+
+            size_t m_Offset = 0;
+
+        public:
+            /// \brief makes an arena current on the calling thread for the lifetime of the scope, restoring the previous one after
+            class current_scope final
+            {
+                    scratch_arena *m_pPrevious;
+
+                public:
+                    current_scope(scratch_arena *pArena);
+
+                    current_scope(const current_scope &) = delete;
+                    current_scope &operator=(const current_scope &) = delete;
+
+                    ~current_scope();
+            };
+
+            /// \brief returns the arena current on the calling thread, nullptr if there is none (e.g. the thread is not a worker)
+            static scratch_arena *current();
+
+            /// \brief returns size bytes aligned to alignment (a power of two), or nullptr if the arena cannot fit them
+            void *try_allocate(const size_t size, const size_t alignment = alignof(std::max_align_t))
+            {
+                if (!m_pData)
+                {
+                    m_Buffer.reset(new unsigned char[m_Capacity]);
+
+                    m_pData = m_Buffer.get();
+                }
+
+                const auto base = reinterpret_cast<std::uintptr_t>(m_pData);
+
+                const auto aligned = ((base + m_Offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+
+                if (aligned > m_Capacity || size > m_Capacity - aligned) return nullptr;
+
+                m_Offset = aligned + size;
+
+                return m_pData + aligned;
+            }
+
+            /// \brief returns memory to the arena if it was the most recent allocation, e.g. a temporary freed before anything else was allocated. Otherwise it is reclaimed by reset.
+            /// \remark a growing vector allocates its new buffer before freeing the old one, so the old buffers stay allocated until reset; reserve up front where the size is known
+            void deallocate(void *p, const size_t size)
+            {
+                if (static_cast<unsigned char *>(p) + size == m_pData + m_Offset) m_Offset -= size;
+            }
+
+            /// \brief true if p was allocated from this arena
+            bool owns(const void *p) const
+            {
+                const auto address = static_cast<const unsigned char *>(p);
+
+                return m_pData && address >= m_pData && address < m_pData + m_Capacity;
+            }
+
+            /// \brief frees everything allocated from the arena
+            void reset() { m_Offset = 0; }
+
+            /// \brief get the number of bytes currently allocated, including alignment padding
+            size_t bytes_used() const { return m_Offset; }
+
+            /// \brief get the size of the arena in bytes
+            size_t capacity() const { return m_Capacity; }
+
+            scratch_arena(size_t capacity);
+            /// \brief uses capacity bytes at pBuffer rather than allocating, e.g. memory backed by huge pages. The buffer must outlive the arena
+            scratch_arena(void *pBuffer, size_t capacity);
+
+            scratch_arena(const scratch_arena &) = delete;
+            scratch_arena &operator=(const scratch_arena &) = delete;
+    };
+
+    /// \brief standard allocator drawing from a scratch_arena, by default the one current when the allocator is constructed.
+    /// when there is no arena, or it is full, the allocator falls back to the global heap, so containers using it work on any thread.
+    /// \code
+    /// group.add_tasks([]()
+    /// {
+    ///     std::vector<int, jfc::scratch_allocator<int>> temporaries;
+    /// });
+    /// \endcode
+    /// \warning containers must be destroyed before the task that created them returns
+    template<class T>
+    class scratch_allocator
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "overaligned types are not supported by the heap fallback");
+
+        scratch_arena *m_pArena;
+
+        public:
+            using value_type = T;
+
+            /// \brief get the arena drawn from, nullptr if only the heap is used
+            scratch_arena *arena() const noexcept { return m_pArena; }
+
+            T *allocate(const size_t count)
+            {
+                if (count > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+
+                if (m_pArena) if (auto p = m_pArena->try_allocate(count * sizeof(T), alignof(T))) return static_cast<T *>(p);
+
+                return static_cast<T *>(::operator new(count * sizeof(T)));
+            }
+
+            void deallocate(T *const p, const size_t count) noexcept
+            {
+                if (m_pArena && m_pArena->owns(p)) m_pArena->deallocate(p, count * sizeof(T));
+                else ::operator delete(p);
+            }
+
+            scratch_allocator() noexcept
+            : m_pArena(scratch_arena::current())
+            {}
+
+            explicit scratch_allocator(scratch_arena *const pArena) noexcept
+            : m_pArena(pArena)
+            {}
+
+            template<class U>
+            scratch_allocator(const scratch_allocator<U> &b) noexcept
+            : m_pArena(b.arena())
+            {}
+    };
+
+    template<class T, class U>
+    bool operator==(const scratch_allocator<T> &a, const scratch_allocator<U> &b) noexcept { return a.arena() == b.arena(); }
+
+    template<class T, class U>
+    bool operator!=(const scratch_allocator<T> &a, const scratch_allocator<U> &b) noexcept { return a.arena() != b.arena(); }
+}
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef JFC_SHARED_MEMORY_QUEUE_H
+#define JFC_SHARED_MEMORY_QUEUE_H
+
+#include <jfc/bounded_queue.h>
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+/// \brief defined if shared memory queues are available on the target: they rely on POSIX shared memory and Linux futexes
+#if defined(__linux__)
+#define JFC_SHARED_MEMORY_SUPPORTED
+#endif
+
+#ifdef JFC_SHARED_MEMORY_SUPPORTED
+
+namespace jfc
+{
+    /// \brief a named POSIX shared memory object (shm_open), mapped into the calling process
+    /// \remark the region is unmapped on destruction. The name persists until unlink is called, by default by the destructor of the region that created it
+    class shared_memory_region final
+    {
+        public:
+            /// \brief whether to create a new object or open an existing one
+            enum class open_mode
+            {
+                /// \brief creates the object, failing if the name is taken. Its contents start zeroed
+                create,
+                /// \brief opens an object created by another region
+                open
+            };
+
+        private:
+            std::string m_Name;
+
+            void *m_pAddress = nullptr;
+
+            size_t m_Size;
+
+            /// \brief true if the destructor is to unlink the name
+            bool m_IsOwner;
+
+        public:
+            /// \brief get the address the region is mapped at in this process
+            void *data() const { return m_pAddress; }
+
+            /// \brief get the size of the region in bytes
+            size_t size() const { return m_Size; }
+
+            /// \brief get the name of the object
+            const std::string &name() const { return m_Name; }
+
+            /// \brief removes the name so that no further region can open it. Existing mappings stay valid
+            void unlink();
+
+            /// \brief name must begin with a '/' and contain no other, see shm_open.
+            /// when opening, size must not exceed the size the object was created with. The creator sizes the object just after creating it, so an opener waits up to a second for it to reach size
+            /// \throws std::system_error if the object cannot be created, opened or mapped
+            shared_memory_region(std::string name, size_t size, open_mode mode);
+
+            shared_memory_region(const shared_memory_region &) = delete;
+            shared_memory_region &operator=(const shared_memory_region &) = delete;
+
+            ~shared_memory_region();
+    };
+
+    namespace detail
+    {
+        /// \brief blocks while word holds expected, until woken by futex_wake. May return spuriously. Works across processes sharing the word
+        void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected);
+
+        /// \brief wakes up to count threads blocked in futex_wait on word
+        void futex_wake(std::atomic<std::uint32_t> &word, int count);
+    }
+
+    /// \brief queue of trivially copyable work items in shared memory, so that several processes, e.g. worker processes kept apart for fault isolation, consume one backlog.
+    /// items are held in a bounded_queue placed in a shared_memory_region. One process creates the queue, the others open it by name.
+    /// blocking calls park on futexes in the region, so a waiting consumer in one process is woken directly by a producer in another.
+    /// \code
+    /// // in each worker process
+    /// jfc::shared_memory_queue<job, 1024> queue("/jobs", jfc::shared_memory_region::open_mode::open);
+    /// jfc::thread_group group(4);
+    /// queue.consume(group, [](const job &j) { run(j); });
+    /// \endcode
+    /// \remark all methods are thread friendly, in any process
+    /// \warning the ring is lock free but not crash proof: a process killed between claiming and releasing a slot leaves that slot unusable, stalling the queue once the ring comes round to it
+    template<class T, size_t capacity_value>
+    class shared_memory_queue final
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "items are copied between processes, so must be trivially copyable");
+        static_assert(std::atomic<size_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free, "the queue must be address free to be shared");
+
+        public:
+            /// \brief alias for item type
+            using value_type = T;
+
+            /// \brief alias for the functor consume passes items to
+            using handler_type = std::function<void(const T &)>;
+
+            /// \brief get the maximum number of items the queue can hold
+            static constexpr size_t capacity() { return capacity_value; }
+
+        private:
+            /// \brief written by the creator once the layout is constructed, so that openers do not see a half made queue
+            static constexpr std::uint32_t READY = 0x6a666371;
+
+            /// \brief assumed size of a cache line, used to keep the producer and consumer futex words from sharing one
+            static constexpr size_t CACHE_LINE_SIZE = 64;
+
+            /// \brief everything placed in the region
+            struct layout_type
+            {
+                std::atomic<std::uint32_t> m_Ready;
+
+                std::atomic<std::uint32_t> m_IsClosed;
+
+                /// \brief futex word bumped on every enqueue and on close
+                alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_ItemSignal;
+
+                std::atomic<std::uint32_t> m_WaitingConsumers;
+
+                /// \brief futex word bumped on every dequeue and on close
+                alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_SpaceSignal;
+
+                std::atomic<std::uint32_t> m_WaitingProducers;
+
+                bounded_queue<T, capacity_value> m_Queue;
+
+                layout_type()
+                : m_Ready(0)
+                , m_IsClosed(0)
+                , m_ItemSignal(0)
+                , m_WaitingConsumers(0)
+                , m_SpaceSignal(0)
+                , m_WaitingProducers(0)
+                {}
+            };
+
+            shared_memory_region m_Region;
+
+            layout_type *m_pLayout;
+
+            static void signal(std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters, const int count)
+            {
+                word.fetch_add(1, std::memory_order_seq_cst);
+
+                if (waiters.load(std::memory_order_seq_cst)) detail::futex_wake(word, count);
+            }
+
+            /// \brief calls attempt until it succeeds or the queue closes, parking on word between attempts.
+            /// word is read before the final attempt, so a signal landing after that attempt changes it and the futex wait returns at once
+            template<class attempt_type>
+            bool wait_for(const attempt_type &attempt, std::atomic<std::uint32_t> &word, std::atomic<std::uint32_t> &waiters)
+            {
+                for (;;)
+                {
+                    if (attempt()) return true;
+
+                    const auto observed = word.load(std::memory_order_seq_cst);
+
+                    if (attempt()) return true;
+
+                    if (m_pLayout->m_IsClosed.load(std::memory_order_acquire)) return false;
+
+                    waiters.fetch_add(1, std::memory_order_seq_cst);
+
+                    detail::futex_wait(word, observed);
+
+                    waiters.fetch_sub(1, std::memory_order_seq_cst);
+                }
+            }
+
+        public:
+            /// \brief adds an item, returns false if the queue is full
+            bool try_enqueue(const T &item)
+            {
+                if (!m_pLayout->m_Queue.try_enqueue(item)) return false;
+
+                signal(m_pLayout->m_ItemSignal, m_pLayout->m_WaitingConsumers, 1);
+
+                return true;
+            }
+
+            /// \brief adds an item, blocking while the queue is full. Returns false if the queue was closed before there was room
+            bool enqueue(const T &item)
+            {
+                if (m_pLayout->m_IsClosed.load(std::memory_order_acquire)) return false;
+
+                return wait_for([&]() { return try_enqueue(item); }, m_pLayout->m_SpaceSignal, m_pLayout->m_WaitingProducers);
+            }
+
+            /// \brief takes the item at the front, returns false if the queue is empty
+            bool try_dequeue(T &item)
+            {
+                if (!m_pLayout->m_Queue.try_dequeue(item)) return false;
+
+                signal(m_pLayout->m_SpaceSignal, m_pLayout->m_WaitingProducers, 1);
+
+                return true;
+            }
+
+            /// \brief takes the item at the front, blocking while the queue is empty. Returns false once the queue is closed and empty
+            bool dequeue(T &item)
+            {
+                return wait_for([&]() { return try_dequeue(item); }, m_pLayout->m_ItemSignal, m_pLayout->m_WaitingConsumers);
+            }
+
+            /// \brief closes the queue in every process: blocked calls return, and consumers stop once the remaining items are taken
+            void close()
+            {
+                m_pLayout->m_IsClosed.store(1, std::memory_order_release);
+
+                signal(m_pLayout->m_ItemSignal, m_pLayout->m_WaitingConsumers, std::numeric_limits<int>::max());
+                signal(m_pLayout->m_SpaceSignal, m_pLayout->m_WaitingProducers, std::numeric_limits<int>::max());
+            }
+
+            /// \brief true if close has been called by any process
+            bool is_closed() const { return m_pLayout->m_IsClosed.load(std::memory_order_acquire); }
+
+            /// \brief get the number of items in the queue. Exact only when no other thread is using the queue
+            size_t size_approx() const { return m_pLayout->m_Queue.size_approx(); }
+
+            /// \brief adds a task to each of group's threads that takes items from the queue and passes them to handler, until the queue is closed and empty.
+            /// each worker takes one item at a time, so the backlog is shared out between processes in proportion to how fast they work through it.
+            /// the tasks occupy the workers until the queue closes, so the queue must outlive them: close it and wait for the group before destroying it
+            /// \throws std::invalid_argument if the group has no threads
+            void consume(thread_group &group, handler_type handler)
+            {
+                if (!group.thread_count()) throw std::invalid_argument("jfc::shared_memory_queue: the group has no threads to consume with");
+
+                auto pHandler = std::make_shared<handler_type>(std::move(handler));
+
+                for (size_t i(0); i < group.thread_count(); ++i) group.add_task_to(i, [this, pHandler]()
+                {
+                    T item;
+
+                    while (dequeue(item)) (*pHandler)(item);
+                });
+            }
+
+            /// \brief creates or opens the queue named name, see shared_memory_region. Opening waits for the creator to finish constructing the queue
+            /// \throws std::system_error if the region cannot be created or opened
+            shared_memory_queue(const std::string &name, const shared_memory_region::open_mode mode)
+            : m_Region(name, sizeof(layout_type), mode)
+            , m_pLayout(static_cast<layout_type *>(m_Region.data()))
+            {
+                if (mode == shared_memory_region::open_mode::create)
+                {
+                    new (m_pLayout) layout_type();
+
+                    m_pLayout->m_Ready.store(READY, std::memory_order_release);
+
+                    detail::futex_wake(m_pLayout->m_Ready, std::numeric_limits<int>::max());
+                }
+                else for (std::uint32_t ready; (ready = m_pLayout->m_Ready.load(std::memory_order_acquire)) != READY;) detail::futex_wait(m_pLayout->m_Ready, ready);
+            }
+
+            shared_memory_queue(const shared_memory_queue &) = delete;
+            shared_memory_queue &operator=(const shared_memory_queue &) = delete;
+    };
+}
+
+#endif
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef JFC_STATIC_TASK_GRAPH_H
+#define JFC_STATIC_TASK_GRAPH_H
+
+#include <jfc/thread_group.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace jfc
+{
+    /// \brief declares a node of a static_task_graph: node_type is run once all of dependency_types have run.
+    /// node_type must be default constructible and callable as void()
+    template<class node_type, class... dependency_types>
+    struct dag_node {};
+
+    /// \brief task graph whose shape is fixed at compile time.
+    /// nodes are types and edges are the type lists of their dag_node declarations. The topological order, dependency counts and successor lists are computed at compile time,
+    /// a cyclic graph or a dependency on an undeclared node fails to compile. Running the graph performs no dynamic allocation beyond the group's queue blocks, and no virtual calls:
+    /// nodes are dispatched through compile time tables of function pointers.
+    /// \code
+    /// static_task_graph<dag_node<load>, dag_node<parse, load>, dag_node<index, load>, dag_node<save, parse, index>> graph;
+    /// graph.run(group);
+    /// \endcode
+    /// \remark a graph may be run repeatedly, but not concurrently with itself
+    template<class... node_declaration_types>
+    class static_task_graph final
+    {
+        static_assert(sizeof...(node_declaration_types) > 0, "a task graph requires at least one node");
+
+        template<class>
+        struct declaration_traits;
+
+        template<class node_type, class... dependency_types>
+        struct declaration_traits<dag_node<node_type, dependency_types...>>
+        {
+            using type = node_type;
+        };
+
+        public:
+            /// \brief alias for the collection of node objects, in declaration order
+            using node_collection_type = std::tuple<typename declaration_traits<node_declaration_types>::type...>;
+
+            /// \brief get the number of nodes in the graph
+            static constexpr size_t node_count() { return sizeof...(node_declaration_types); }
+
+            /// \brief returns the declaration index of a node type
+            template<class node_type>
+            static constexpr size_t index_of()
+            {
+                constexpr bool matches[] = {std::is_same<node_type, typename declaration_traits<node_declaration_types>::type>::value...};
+
+                for (size_t i(0); i < node_count(); ++i) if (matches[i]) return i;
+
+                return node_count();
+            }
+
+        private:
+            using adjacency_type = std::array<std::array<bool, node_count()>, node_count()>;
+
+            template<class node_type, class... dependency_types>
+            static constexpr void add_edges(adjacency_type &adjacency, [[maybe_unused]] const size_t dependent, dag_node<node_type, dependency_types...> *)
+            {
+                static_assert(((index_of<dependency_types>() < node_count()) && ...), "a node depends on a type that is not a node of the graph");
+
+                ((adjacency[index_of<dependency_types>()][dependent] = true), ...);
+            }
+
+            /// \brief adjacency[a][b] is true if b depends on a
+            static constexpr adjacency_type make_adjacency()
+            {
+                adjacency_type adjacency{};
+
+                size_t dependent(0);
+
+                (add_edges(adjacency, dependent++, static_cast<node_declaration_types *>(nullptr)), ...);
+
+                return adjacency;
+            }
+
+            static constexpr adjacency_type ADJACENCY = make_adjacency();
+
+            static constexpr size_t count_edges()
+            {
+                size_t count(0);
+
+                for (size_t a(0); a < node_count(); ++a) for (size_t b(0); b < node_count(); ++b) count += ADJACENCY[a][b];
+
+                return count;
+            }
+
+            static constexpr size_t EDGE_COUNT = count_edges();
+
+            static constexpr std::array<size_t, node_count()> make_dependency_counts()
+            {
+                std::array<size_t, node_count()> counts{};
+
+                for (size_t a(0); a < node_count(); ++a) for (size_t b(0); b < node_count(); ++b) counts[b] += ADJACENCY[a][b];
+
+                return counts;
+            }
+
+            /// \brief successors of node i are SUCCESSORS[SUCCESSOR_OFFSETS[i], SUCCESSOR_OFFSETS[i + 1])
+            static constexpr std::array<size_t, node_count() + 1> make_successor_offsets()
+            {
+                std::array<size_t, node_count() + 1> offsets{};
+
+                for (size_t a(0); a < node_count(); ++a)
+                {
+                    offsets[a + 1] = offsets[a];
+
+                    for (size_t b(0); b < node_count(); ++b) offsets[a + 1] += ADJACENCY[a][b];
+                }
+
+                return offsets;
+            }
+
+            static constexpr std::array<size_t, EDGE_COUNT + 1> make_successors()
+            {
+                std::array<size_t, EDGE_COUNT + 1> successors{};
+
+                size_t edge(0);
+
+                for (size_t a(0); a < node_count(); ++a) for (size_t b(0); b < node_count(); ++b) if (ADJACENCY[a][b]) successors[edge++] = b;
+
+                return successors;
+            }
+
+            struct topological_sort_type
+            {
+                std::array<size_t, node_count()> m_Order;
+
+                bool m_IsAcyclic;
+            };
+
+            /// \brief kahn's algorithm, preferring lower declaration indices so the order is stable
+            static constexpr topological_sort_type make_topological_order()
+            {
+                auto remaining = make_dependency_counts();
+
+                std::array<bool, node_count()> is_placed{};
+
+                topological_sort_type result{};
+
+                for (size_t position(0); position < node_count(); ++position)
+                {
+                    size_t next(node_count());
+
+                    for (size_t i(0); i < node_count() && next == node_count(); ++i) if (!is_placed[i] && !remaining[i]) next = i;
+
+                    if (next == node_count()) return result;
+
+                    is_placed[next] = true;
+
+                    result.m_Order[position] = next;
+
+                    for (size_t b(0); b < node_count(); ++b) remaining[b] -= ADJACENCY[next][b];
+                }
+
+                result.m_IsAcyclic = true;
+
+                return result;
+            }
+
+            static constexpr topological_sort_type TOPOLOGICAL_SORT = make_topological_order();
+
+            static_assert(TOPOLOGICAL_SORT.m_IsAcyclic, "the task graph contains a cycle");
+
+        public:
+            /// \brief number of dependencies of each node, in declaration order
+            static constexpr std::array<size_t, node_count()> DEPENDENCY_COUNTS = make_dependency_counts();
+
+            /// \brief declaration indices of the nodes in an order where every node follows its dependencies
+            static constexpr std::array<size_t, node_count()> TOPOLOGICAL_ORDER = TOPOLOGICAL_SORT.m_Order;
+
+        private:
+            static constexpr std::array<size_t, node_count() + 1> SUCCESSOR_OFFSETS = make_successor_offsets();
+
+            static constexpr std::array<size_t, EDGE_COUNT + 1> SUCCESSORS = make_successors();
+
+            using dispatch_type = void (*)(static_task_graph &);
+
+            template<size_t index>
+            static void invoke(static_task_graph &graph)
+            {
+                std::get<index>(graph.m_Nodes)();
+            }
+
+            /// \brief runs a node, then submits each successor whose last dependency this was
+            template<size_t index>
+            static void execute(static_task_graph &graph)
+            {
+                std::get<index>(graph.m_Nodes)();
+
+                for (auto edge = SUCCESSOR_OFFSETS[index]; edge < SUCCESSOR_OFFSETS[index + 1]; ++edge)
+                {
+                    const auto successor = SUCCESSORS[edge];
+
+                    if (graph.m_Remaining[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) graph.submit(successor);
+                }
+
+                graph.m_OutstandingCount.fetch_sub(1, std::memory_order_release);
+            }
+
+            template<size_t... indices>
+            static constexpr std::array<dispatch_type, node_count()> make_invoke_table(std::index_sequence<indices...>)
+            {
+                return {&invoke<indices>...};
+            }
+
+            template<size_t... indices>
+            static constexpr std::array<dispatch_type, node_count()> make_execute_table(std::index_sequence<indices...>)
+            {
+                return {&execute<indices>...};
+            }
+
+            static constexpr std::array<dispatch_type, node_count()> INVOKE_TABLE = make_invoke_table(std::make_index_sequence<node_count()>());
+
+            static constexpr std::array<dispatch_type, node_count()> EXECUTE_TABLE = make_execute_table(std::make_index_sequence<node_count()>());
+
+            node_collection_type m_Nodes;
+
+            /// \brief dependencies of each node not yet run during the current run
+            std::array<std::atomic<size_t>, node_count()> m_Remaining;
+
+            /// \brief nodes not yet run during the current run
+            std::atomic<size_t> m_OutstandingCount;
+
+            thread_group *m_pGroup = nullptr;
+
+            /// \brief the group task refers to the node by index, small enough for std::function to store without allocating
+            void submit(const size_t index)
+            {
+                m_pGroup->add_tasks([this, index]()
+                {
+                    EXECUTE_TABLE[index](*this);
+                });
+            }
+
+        public:
+            /// \brief access a node object, e.g. to set its inputs before a run or read its outputs after
+            template<class node_type>
+            node_type &get()
+            {
+                static_assert(index_of<node_type>() < node_count(), "type is not a node of the graph");
+
+                return std::get<index_of<node_type>()>(m_Nodes);
+            }
+
+            /// \brief runs every node on the group, each once its dependencies have run.
+            /// the calling thread helps the group with its tasks until the whole graph has run
+            void run(thread_group &group)
+            {
+                m_pGroup = &group;
+
+                for (size_t i(0); i < node_count(); ++i) m_Remaining[i].store(DEPENDENCY_COUNTS[i], std::memory_order_relaxed);
+
+                m_OutstandingCount.store(node_count(), std::memory_order_relaxed);
+
+                for (size_t i(0); i < node_count(); ++i) if (!DEPENDENCY_COUNTS[i]) submit(i);
+
+                while (m_OutstandingCount.load(std::memory_order_acquire))
+                {
+                    if (auto task = group.try_get_task()) (*task)();
+                    else std::this_thread::yield();
+                }
+            }
+
+            /// \brief runs every node on the calling thread, in topological order
+            void run_sequential()
+            {
+                for (const auto index : TOPOLOGICAL_ORDER) INVOKE_TABLE[index](*this);
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,328 @@
+#ifndef JFC_STATIC_THREAD_GROUP_H
+#define JFC_STATIC_THREAD_GROUP_H
+
+#include <jfc/bounded_queue.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#define JFC_STATIC_THREAD_GROUP_USES_PTHREADS
+#endif
+
+namespace jfc
+{
+    /// \brief move only callable stored entirely inline, in storage_size bytes. Never allocates: callables that do not fit are rejected at compile time
+    template<size_t storage_size>
+    class inplace_task final
+    {
+        alignas(std::max_align_t) unsigned char m_Storage[storage_size];
+
+        /// \brief invokes the stored callable
+        void (*m_pInvoke)(void *) = nullptr;
+
+        /// \brief move constructs the stored callable into pTo if pTo is nonnull, then destroys the original
+        void (*m_pRelocate)(void *pFrom, void *pTo) = nullptr;
+
+        void reset()
+        {
+            if (m_pRelocate) m_pRelocate(m_Storage, nullptr);
+
+            m_pInvoke = nullptr;
+            m_pRelocate = nullptr;
+        }
+
+        void take(inplace_task &b)
+        {
+            if (b.m_pRelocate) b.m_pRelocate(b.m_Storage, m_Storage);
+
+            m_pInvoke = b.m_pInvoke;
+            m_pRelocate = b.m_pRelocate;
+
+            b.m_pInvoke = nullptr;
+            b.m_pRelocate = nullptr;
+        }
+
+    public:
+        /// \brief true if a callable is stored
+        explicit operator bool() const { return m_pInvoke != nullptr; }
+
+        void operator()() { m_pInvoke(m_Storage); }
+
+        inplace_task() = default;
+
+        template<class functor_type, class = typename std::enable_if<!std::is_same<typename std::decay<functor_type>::type, inplace_task>::value>::type>
+        inplace_task(functor_type &&functor)
+        {
+            using stored_type = typename std::decay<functor_type>::type;
+
+            static_assert(sizeof(stored_type) <= storage_size, "callable is too large for the task storage, increase the storage size");
+            static_assert(alignof(stored_type) <= alignof(std::max_align_t), "callable is overaligned for the task storage");
+
+            new (m_Storage) stored_type(std::forward<functor_type>(functor));
+
+            m_pInvoke = [](void *pStorage)
+            {
+                (*std::launder(static_cast<stored_type *>(pStorage)))();
+            };
+
+            m_pRelocate = [](void *pFrom, void *pTo)
+            {
+                auto &from = *std::launder(static_cast<stored_type *>(pFrom));
+
+                if (pTo) new (pTo) stored_type(std::move(from));
+
+                from.~stored_type();
+            };
+        }
+
+        inplace_task(inplace_task &&b) { take(b); }
+
+        inplace_task &operator=(inplace_task &&b)
+        {
+            if (this != &b)
+            {
+                reset();
+
+                take(b);
+            }
+
+            return *this;
+        }
+
+        ~inplace_task() { reset(); }
+    };
+
+    /// \brief thread group whose size and queue capacity are fixed at compile time, for targets that must not allocate.
+    /// workers, thread ids and queued tasks are held in fixed size arrays inside the group, the queue is a fixed capacity lock free ring, and tasks are stored inline;
+    /// neither construction nor steady state performs dynamic allocation. On POSIX targets workers are created with pthreads directly, since std::thread allocates its launch state.
+    /// \remark all methods are thread friendly
+    /// \remark the group refers to itself from its workers, so it is neither copyable nor movable
+    template<size_t thread_count_value, size_t queue_capacity_value, size_t task_storage_size = 64>
+    class static_thread_group final
+    {
+        public:
+            /// \brief alias for task functor
+            using task_type = inplace_task<task_storage_size>;
+
+            /// \brief alias for thread id collection
+            using thread_id_collection_type = std::array<std::thread::id, thread_count_value>;
+
+        private:
+            /// \brief number of consecutive failed attempts to find work before a worker parks
+            static constexpr size_t PARK_SPIN_COUNT = 64;
+
+#ifdef JFC_STATIC_THREAD_GROUP_USES_PTHREADS
+            using native_thread_type = pthread_t;
+#else
+            using native_thread_type = std::thread;
+#endif
+
+            bounded_queue<task_type, queue_capacity_value> m_Tasks;
+
+            std::array<native_thread_type, thread_count_value> m_Threads;
+
+            thread_id_collection_type m_Thread_IDs;
+
+            /// \brief number of workers that have recorded their id, construction waits for all of them
+            std::atomic<size_t> m_StartedCount;
+
+            /// \brief exit flag for the worker's loops
+            std::atomic<bool> m_GroupIsDestroyed;
+
+            /// \brief parking, as in thread_group: a parked worker sleeps until the epoch changes from the value read before it last looked for work
+            std::mutex m_ParkMutex;
+
+            std::condition_variable m_ParkCondition;
+
+            std::atomic<size_t> m_ParkedCount;
+
+            std::atomic<std::uint64_t> m_WorkEpoch;
+
+            void notify_work()
+            {
+                m_WorkEpoch.fetch_add(1);
+
+                if (m_ParkedCount.load())
+                {
+                    { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+                    m_ParkCondition.notify_one();
+                }
+            }
+
+            void work(const size_t index)
+            {
+                m_Thread_IDs[index] = std::this_thread::get_id();
+
+                m_StartedCount.fetch_add(1, std::memory_order_release);
+
+                task_type task;
+
+                size_t idle_count(0);
+
+                for (;;)
+                {
+                    const auto epoch = m_WorkEpoch.load();
+
+                    if (m_Tasks.try_dequeue(task))
+                    {
+                        task();
+
+                        task = task_type();
+
+                        idle_count = 0;
+                    }
+                    else if (m_GroupIsDestroyed.load(std::memory_order_relaxed)) break;
+                    else if (++idle_count < PARK_SPIN_COUNT) std::this_thread::yield();
+                    else
+                    {
+                        m_ParkedCount.fetch_add(1);
+
+                        {
+                            std::unique_lock<std::mutex> lock(m_ParkMutex);
+
+                            m_ParkCondition.wait(lock, [this, epoch]()
+                            {
+                                return m_WorkEpoch.load() != epoch || m_GroupIsDestroyed.load();
+                            });
+                        }
+
+                        m_ParkedCount.fetch_sub(1);
+
+                        idle_count = 0;
+                    }
+                }
+            }
+
+#ifdef JFC_STATIC_THREAD_GROUP_USES_PTHREADS
+            /// \brief argument of each worker's start routine
+            struct worker_argument_type
+            {
+                static_thread_group *m_pGroup;
+
+                size_t m_Index;
+            };
+
+            std::array<worker_argument_type, thread_count_value> m_WorkerArguments;
+
+            static void *worker_main(void *pArgument)
+            {
+                const auto &argument = *static_cast<worker_argument_type *>(pArgument);
+
+                argument.m_pGroup->work(argument.m_Index);
+
+                return nullptr;
+            }
+#endif
+
+        public:
+            /// \brief get the number of threads in the group
+            static constexpr size_t thread_count() { return thread_count_value; }
+
+            /// \brief get the maximum number of queued tasks
+            static constexpr size_t queue_capacity() { return queue_capacity_value; }
+
+            /// brief returns a collection of IDs for the threads in the group
+            const thread_id_collection_type &thread_ids() const { return m_Thread_IDs; }
+
+            /// \brief adds a task to the queue, returns false (leaving task untouched) if the queue is full
+            bool try_add_task(task_type &&task)
+            {
+                if (!m_Tasks.try_enqueue(std::move(task))) return false;
+
+                notify_work();
+
+                return true;
+            }
+
+            /// \brief adds a task to the queue. While the queue is full the calling thread runs queued tasks to make room
+            void add_task(task_type &&task)
+            {
+                while (!try_add_task(std::move(task)))
+                {
+                    if (!try_run_task()) std::this_thread::yield();
+                }
+            }
+
+            /// \brief removes and runs a task on the calling thread, returns false if the queue was empty.
+            /// this can be called publicly to allow threads outside the group to help perform its tasks
+            bool try_run_task()
+            {
+                task_type task;
+
+                if (!m_Tasks.try_dequeue(task)) return false;
+
+                task();
+
+                return true;
+            }
+
+            /// \brief starts the workers. Waits until each has recorded its id, so thread_ids is complete on return
+            /// \throws std::runtime_error if a worker cannot be started
+            static_thread_group()
+            : m_StartedCount(0)
+            , m_GroupIsDestroyed(false)
+            , m_ParkedCount(0)
+            , m_WorkEpoch(0)
+            {
+                for (size_t i(0); i < thread_count_value; ++i)
+                {
+#ifdef JFC_STATIC_THREAD_GROUP_USES_PTHREADS
+                    m_WorkerArguments[i] = {this, i};
+
+                    if (pthread_create(&m_Threads[i], nullptr, &worker_main, &m_WorkerArguments[i]))
+                    {
+                        m_GroupIsDestroyed = true;
+
+                        { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+                        m_ParkCondition.notify_all();
+
+                        for (size_t j(0); j < i; ++j) pthread_join(m_Threads[j], nullptr);
+
+                        throw std::runtime_error("jfc::static_thread_group: could not start worker");
+                    }
+#else
+                    m_Threads[i] = std::thread([this, i]() { work(i); });
+#endif
+                }
+
+                while (m_StartedCount.load(std::memory_order_acquire) != thread_count_value) std::this_thread::yield();
+            }
+
+            static_thread_group(const static_thread_group &) = delete;
+            static_thread_group &operator=(const static_thread_group &) = delete;
+
+            /// \brief workers finish the queued tasks, then exit
+            ~static_thread_group()
+            {
+                m_GroupIsDestroyed = true;
+
+                m_WorkEpoch.fetch_add(1);
+
+                { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+                m_ParkCondition.notify_all();
+
+#ifdef JFC_STATIC_THREAD_GROUP_USES_PTHREADS
+                for (auto &thread : m_Threads) pthread_join(thread, nullptr);
+#else
+                for (auto &thread : m_Threads) thread.join();
+#endif
+            }
+    };
+}
+
+#endif
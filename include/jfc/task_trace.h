@@ -0,0 +1,183 @@
+#ifndef JFC_TASK_TRACE_H
+#define JFC_TASK_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace jfc
+{
+    /// \brief a record of the tasks executed by a thread_group: when each ran, where, and which tasks it depended on.
+    /// traces are captured by a task_trace_recorder, can be saved and loaded as text, and replayed offline by simulate to predict how the workload would scale
+    class task_trace final
+    {
+        public:
+            /// \brief alias for task ids. Ids start at 1, 0 means "no task"
+            using id_type = std::uint64_t;
+
+            /// \brief one executed task. Times are nanoseconds since the recorder was created
+            struct record_type
+            {
+                id_type id;
+
+                /// \brief the task that submitted this one, 0 if it was submitted from outside any traced task
+                id_type parent;
+
+                /// \brief index of the worker that ran the task, -1 if it was run by a thread outside the group (e.g. via try_get_task)
+                std::int64_t worker;
+
+                std::int64_t submit_time;
+
+                std::int64_t start_time;
+
+                std::int64_t end_time;
+
+                /// \brief time spent running other traced tasks nested inside this one, e.g. while helping via try_get_task
+                std::int64_t nested_time;
+
+                /// \brief tasks this task waited for while running, see task_trace_recorder::record_dependency
+                std::vector<id_type> dependencies;
+            };
+
+            /// \brief alias for record collection
+            using record_collection_type = std::vector<record_type>;
+
+            /// \brief order in which the simulated scheduler picks among ready tasks
+            enum class scheduling_policy
+            {
+                /// \brief earliest released first, as the group's shared queue
+                fifo,
+
+                /// \brief most recently released first, as a work stealing scheduler's local deque
+                lifo,
+
+                /// \brief longest task first, a greedy approximation of critical path scheduling
+                longest_first
+            };
+
+            /// \brief predicted behaviour of the workload under a given configuration
+            struct simulation_result_type
+            {
+                size_t worker_count;
+
+                scheduling_policy policy;
+
+                /// \brief time from the first submission to the last completion, in nanoseconds
+                std::int64_t makespan;
+
+                /// \brief fraction of the workers' time spent running tasks, in [0, 1]
+                double utilisation;
+            };
+
+            /// \brief the limits on the workload's parallelism, as if it were run on unboundedly many workers
+            struct critical_path_type
+            {
+                /// \brief total run time of all tasks, in nanoseconds
+                std::int64_t work;
+
+                /// \brief length of the longest chain of spawns and dependencies from the first submission, in nanoseconds. No number of workers can finish sooner
+                std::int64_t span;
+
+                /// \brief work / span: the most workers the workload can keep busy on average
+                double parallelism;
+
+                /// \brief the tasks forming the longest chain, in execution order
+                std::vector<id_type> tasks;
+            };
+
+        private:
+            struct graph_type;
+
+            record_collection_type m_Records;
+
+        public:
+            /// \brief get the recorded tasks, in order of completion
+            const record_collection_type &records() const;
+
+            /// \brief time from the first submission to the last completion, as recorded
+            std::int64_t recorded_makespan() const;
+
+            /// \brief replays the trace on workerCount simulated workers.
+            /// each task runs for its recorded duration less its nested time. A task is released once its parent has reached the point at which it submitted it;
+            /// tasks submitted from outside the group are released at their recorded submission time. A task that reaches its end before its dependencies have completed
+            /// gives its worker to other tasks, as a task helping via try_get_task would, and completes once they have. Scheduling overhead is not modelled
+            /// \throws std::invalid_argument if workerCount is 0
+            /// \throws std::runtime_error if the dependencies are cyclic
+            simulation_result_type simulate(size_t workerCount, scheduling_policy policy = scheduling_policy::fifo) const;
+
+            /// \brief computes the work, span and critical path of the trace, under the model used by simulate
+            /// \throws std::runtime_error if the dependencies are cyclic
+            critical_path_type critical_path() const;
+
+            /// \brief prints a summary of the trace: work, span and parallelism, the recorded makespan and time spent queued,
+            /// and the topTaskCount longest tasks on the critical path. A recorded makespan close to the span means the critical path is the limit,
+            /// one well above both the span and work / worker count points to scheduling overhead or too few workers
+            void print_report(std::ostream &output, size_t topTaskCount = 10) const;
+
+            /// \brief writes the trace as text, one task per line
+            void write(std::ostream &output) const;
+
+            /// \brief reads a trace written by write
+            /// \throws std::runtime_error if the input is not a trace
+            static task_trace read(std::istream &input);
+
+            task_trace() = default;
+
+            task_trace(record_collection_type records);
+    };
+
+    /// \brief captures a task_trace from a live thread_group, see thread_group::set_trace_recorder.
+    /// each traced task costs a few uncontended lock acquisitions, so recorders are meant for diagnostic runs rather than production
+    /// \remark all methods are thread friendly
+    class task_trace_recorder final
+    {
+        public:
+            /// \brief alias for task ids
+            using id_type = task_trace::id_type;
+
+        private:
+            using clock_type = std::chrono::steady_clock;
+
+            const clock_type::time_point m_StartTime;
+
+            mutable std::mutex m_Mutex;
+
+            /// \brief records indexed by id - 1, including tasks not yet run
+            task_trace::record_collection_type m_Records;
+
+            /// \brief ids of completed tasks, in order of completion
+            std::vector<id_type> m_Completed;
+
+            std::int64_t now() const;
+
+        public:
+            /// \brief registers a submitted task, returning its id. The parent is the traced task running on the calling thread, if any
+            id_type on_submit();
+
+            /// \brief marks the task as started on the calling thread
+            void on_start(id_type id, std::int64_t worker);
+
+            /// \brief marks the task as finished on the calling thread
+            void on_finish(id_type id);
+
+            /// \brief records that the traced task running on the calling thread waited for predecessor to complete
+            void record_dependency(id_type predecessor);
+
+            /// \brief returns the id of the innermost task of this recorder running on the calling thread, if any.
+            /// a task may publish its id so that later tasks can record a dependency on it
+            std::optional<id_type> current_task_id() const;
+
+            /// \brief returns a trace of the tasks completed so far
+            task_trace trace() const;
+
+            task_trace_recorder();
+
+            task_trace_recorder(const task_trace_recorder &) = delete;
+            task_trace_recorder &operator=(const task_trace_recorder &) = delete;
+    };
+}
+
+#endif
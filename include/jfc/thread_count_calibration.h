@@ -0,0 +1,43 @@
+#ifndef JFC_THREAD_COUNT_CALIBRATION_H
+#define JFC_THREAD_COUNT_CALIBRATION_H
+
+#include <jfc/thread_group.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace jfc
+{
+    /// \brief a representative workload, run to completion on the group it is given.
+    /// the call must not return before the work it adds to the group is done; the calling thread may help via try_get_task
+    using calibration_workload_type = std::function<void(thread_group &)>;
+
+    /// \brief parameters of calibrate_thread_count
+    struct calibration_options_type
+    {
+        /// \brief group sizes to try. If empty: powers of two below hardware_concurrency, hardware_concurrency - 1 and hardware_concurrency
+        std::vector<size_t> thread_counts;
+
+        /// \brief timed runs per group size, the fastest of which is kept. Each size also gets one untimed warm up run
+        size_t repetitions = 3;
+
+        /// \brief fraction by which a smaller group may be slower than the fastest and still be chosen, since the spare threads are better left to the rest of the process
+        double tolerance = 0.05;
+
+        /// \brief file in which results are cached, or empty to always calibrate.
+        /// a cached result is only used if it was measured for the same key on a machine with the same hardware_concurrency
+        std::string cache_path;
+
+        /// \brief identifies the workload within the cache file, must not contain whitespace
+        std::string cache_key = "default";
+    };
+
+    /// \brief returns the group size at which the workload runs fastest, measured by running it on a fresh thread_group of each candidate size.
+    /// if options.cache_path names a file holding a result for options.cache_key, that result is returned without running the workload; otherwise the result is added to the file
+    /// \throws std::invalid_argument if repetitions is 0, tolerance is negative, or the cache key is empty or contains whitespace
+    /// \throws std::runtime_error if the cache file cannot be written
+    size_t calibrate_thread_count(const calibration_workload_type &workload, const calibration_options_type &options = {});
+}
+
+#endif
@@ -2,15 +2,21 @@
 #define JFC_THREAD_GROUP_H
 
 #include <algorithm>
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <optional>
+#include <string>
 #include <thread>
 #include <vector>
 
 namespace jfc
 {
+    class task_trace_recorder;
+
     /// \brief task-based concurrency abstraction.
     /// instantiates a number of threads at construction, provides tasks for them to execute via a synchronized queue.
+    /// each worker owns a scratch_arena for the temporaries of the task it is running, reset after every task.
     /// \remark all methods are thread friendly
     /// \remark all const methods are synchronization free
     /// \remark all mutable methods incur synchronization costs via atomic operations
@@ -21,20 +27,151 @@ namespace jfc
             using task_type = std::function<void()>;
 
             /// \brief alias for thread collection
-            using thread_collection_type = std::vector<std::thread>;
+            /// \deprecated the group no longer holds its threads as std::thread, so nothing in the interface uses this. Kept so that code naming it still compiles
+            using thread_collection_type [[deprecated("jfc::thread_group no longer holds std::threads; use thread_id_collection_type to refer to the group's threads")]] = std::vector<std::thread>;
 
             /// \brief alias for thread id collection
             using thread_id_collection_type = std::vector<std::thread::id>;
 
+            /// \brief alias for tenant handles, see add_tenant
+            using tenant_id_type = size_t;
+
+            /// \brief clock against which task deadlines are measured
+            using clock_type = std::chrono::steady_clock;
+
+            /// \brief alias for task deadlines
+            using deadline_type = clock_type::time_point;
+
+            /// \brief alias for the functor notified when a task is dropped for missing its deadline. Receives the deadline that was missed
+            using deadline_missed_handler_type = std::function<void(deadline_type)>;
+
+            /// \brief alias for a lazy stream of tasks, see add_task_source. Returns the next task, or an empty optional once exhausted
+            using task_generator_type = std::function<std::optional<task_type>()>;
+
+            /// \brief alias for the body of an index range task source, called once per index
+            using index_task_type = std::function<void(size_t)>;
+
+            /// \brief alias for the predicate polled by run_as_worker, returning true ends the call
+            using stop_condition_type = std::function<bool()>;
+
+            /// \brief counters describing the work done by a worker
+            struct worker_stats_type
+            {
+                /// \brief index of the worker, see current_worker_index
+                size_t worker_index;
+
+                /// \brief number of tasks the worker has run
+                size_t tasks_executed;
+
+                /// \brief number of times the worker ran out of work and parked
+                size_t times_parked;
+
+                /// \brief true if the worker is an external thread attached via run_as_worker
+                bool is_external;
+            };
+
+            /// \brief alias for worker stats collection
+            using worker_stats_collection_type = std::vector<worker_stats_type>;
+
+            /// \brief when tasks added to the group's queues are run by the submitting thread instead, see set_inline_execution
+            enum class inline_execution_mode
+            {
+                /// \brief tasks are always queued
+                never,
+
+                /// \brief tasks are run inline while none of the group's threads take shared work: the group has no threads, e.g. the default constructed group on a single CPU, or its active worker count is 0
+                when_no_workers,
+
+                /// \brief tasks are always run inline
+                always
+            };
+
+            /// \brief attributes of the threads a group creates, to tune memory and CPU priority per group.
+            /// stack size is honoured on POSIX targets. Names and scheduling are applied on Linux and ignored elsewhere
+            struct thread_attributes_type
+            {
+                /// \brief how the threads are scheduled against the other threads of the system
+                enum class scheduling_policy_type
+                {
+                    /// \brief the default time sharing policy (SCHED_OTHER), weighted by nice
+                    normal,
+
+                    /// \brief runs only when nothing else wants the CPU (SCHED_IDLE), e.g. for background groups
+                    idle,
+
+                    /// \brief real time, first in first out (SCHED_FIFO) at realtime_priority. Usually requires privileges (CAP_SYS_NICE)
+                    fifo
+                };
+
+                /// \brief stack size of each thread in bytes, 0 for the platform default (typically 8 MiB on Linux). Raised to the platform minimum if smaller
+                size_t stack_size = 0;
+
+                /// \brief threads are named name followed by their index, as shown by top and perf. Linux keeps 15 characters, so the name is shortened to keep the index. Empty leaves the threads unnamed
+                std::string name;
+
+                scheduling_policy_type scheduling_policy = scheduling_policy_type::normal;
+
+                /// \brief nice value under the normal policy, from -20 (favoured) to 19. Going below the process's nice value requires privileges
+                int nice = 0;
+
+                /// \brief priority under the fifo policy, from 1 to 99
+                int realtime_priority = 1;
+            };
+
+            /// \brief how a group allocates the memory it owns: the blocks of its task queues and the workers' scratch arenas
+            struct memory_attributes_type
+            {
+                /// \brief backs the queues and scratch arenas with 2 MB pages where the system allows, see huge_page_region, so that millions of queued tasks need far fewer TLB entries.
+                /// memory is drawn from a huge_page_arena owned by the group, and scratch arenas are allocated up front rather than on first use.
+                /// \warning the arena only grows: no queue memory is returned until the group is destroyed. That includes storage a queue frees as it grows, such as its producer hash and block indices,
+                /// and each distinct thread that submits tasks gets its own producer, blocks and index, so memory grows with the number of submitting threads. Suits groups fed by a fixed set of threads.
+                /// closures too large for std::function's inline storage are still allocated on the heap, by std::function
+                bool huge_pages = false;
+            };
+
+            /// \brief what tenants are charged for running their tasks, see set_tenant_charging
+            enum class tenant_charge_mode
+            {
+                /// \brief the time each task took to run
+                elapsed_time,
+
+                /// \brief a fixed cost per task: a tenant of weight w runs w tasks each round. Suits tasks of similar length, and saves reading the clock around every task
+                task_count
+            };
+
+            /// \brief where add_tasks places tasks that have no tenant or deadline, see set_task_placement
+            enum class task_placement_mode
+            {
+                /// \brief one queue shared by every worker
+                shared_queue,
+
+                /// \brief a queue per active worker: each task goes to the shorter of two chosen at random
+                two_choices
+            };
+
+            /// \brief how the workers synchronize around a broadcast functor
+            enum class broadcast_mode
+            {
+                /// \brief each worker runs the functor when it next checks its mailbox, then carries on
+                independent,
+
+                /// \brief each worker runs the functor, then waits until every worker has run it before taking other work.
+                /// barriers broadcast concurrently from several threads are run by every worker in the same order. A paused worker runs the functor only after resume, so until then the workers that have run it stay blocked in the barrier, without consuming CPU
+                barrier
+            };
+
         private:
             struct shared_data_type;
+
+            /// \brief a thread of the group, created according to the group's thread_attributes_type
+            class thread_type;
             
             /// \brief shared data is stored in a shared_ptr to ensure it lives until the final thread participating in the consumption of the task collection has stopped doing work
             /// this refers to at least the number of threads in m_Threads, but because the queue is publicly accessible it also refers to external threads executing a functor returned by try_get_task after this thread_group has fallen out of scope
             std::shared_ptr<shared_data_type> m_SharedData; 
 
             /// \brief the threads in the group
-            thread_collection_type m_Threads;
+            std::vector<std::unique_ptr<thread_type>> m_Threads;
 
             /// \brief IDs of all threads contained in the group
             thread_id_collection_type m_Thread_IDs;
@@ -51,10 +188,144 @@ namespace jfc
             /// \overload
             void add_tasks(task_type &&task);
 
+            /// \brief registers a tenant: a sub queue whose tasks share worker time fairly with other tenants.
+            /// tenants are served by weighted deficit round robin, each receiving worker time in proportion to its weight,
+            /// regardless of how many tasks it submits. Time is measured by running the tasks, so a tenant submitting long tasks does not gain an advantage over one submitting short ones; see set_tenant_charging to charge per task instead.
+            /// \remark tasks added without a tenant are preferred over tenant tasks; in multi-tenant use, submit all work via a tenant
+            /// \throws std::invalid_argument if weight is 0
+            tenant_id_type add_tenant(size_t weight = 1);
+
+            /// \brief adds a collection of tasks to the sub queue of the specified tenant
+            /// \throws std::out_of_range if the tenant was not returned by add_tenant
+            void add_tasks(tenant_id_type tenant, std::vector<task_type> &&tasks);
+            /// \overload
+            void add_tasks(tenant_id_type tenant, task_type &&task);
+
+            /// \brief sets what tenants are charged for running their tasks. Defaults to elapsed_time
+            void set_tenant_charging(tenant_charge_mode mode);
+
+            /// \brief get the mode set by set_tenant_charging
+            tenant_charge_mode tenant_charging() const;
+
+            /// \brief adds a collection of tasks that are worthless if not started by the deadline.
+            /// deadline tasks are preferred over all other tasks and are run earliest deadline first.
+            /// a deadline task that has not started by its deadline is dropped: it is destroyed without being run, the dropped task count is incremented and the deadline missed handler is called
+            void add_tasks(std::vector<task_type> &&tasks, deadline_type deadline);
+            /// \overload
+            void add_tasks(task_type &&task, deadline_type deadline);
+
+            /// \brief registers a lazy source of tasks, pulled by workers when they find no other work, so that huge or unbounded streams run in constant memory.
+            /// a worker pulls up to chunkSize tasks per call, under a lock per source since the generator need not be thread safe, and runs them in order as one task. The source is released once the generator returns an empty optional.
+            /// several sources are pulled from in turn. If inline execution applies (see set_inline_execution), the whole stream is run by the caller before returning
+            /// \warning the group's destructor waits for registered sources to be exhausted, so an unbounded generator must be given a way to stop
+            /// \throws std::invalid_argument if chunkSize is 0
+            void add_task_source(task_generator_type generator, size_t chunkSize = 1);
+            /// \brief registers a source calling body(i) for each i in [0, count), pulled as add_task_source above.
+            /// indices are claimed chunkSize at a time from an atomic cursor, without a lock
+            void add_task_source(size_t count, index_task_type body, size_t chunkSize = 1);
+
+            /// \brief sets the functor called (by the thread that dropped the task) each time a deadline task is dropped
+            void set_deadline_missed_handler(deadline_missed_handler_type handler);
+
+            /// \brief sets whether add_tasks runs tasks on the submitting thread rather than queueing them, so code need not special case groups without threads. Defaults to never.
+            /// inline tasks run in order before add_tasks returns, with no queueing overhead. A deadline task is dropped if its deadline has passed when its turn comes, and tenants are ignored.
+            /// an exception thrown by an inline task propagates out of add_tasks, and the tasks after it are not run. add_task_to and broadcast are unaffected
+            /// \warning a task that adds tasks to its own group recurses rather than queueing
+            void set_inline_execution(inline_execution_mode mode);
+
+            /// \brief get the mode set by set_inline_execution
+            inline_execution_mode inline_execution() const;
+
+            /// \brief sets where add_tasks places tasks that have no tenant or deadline. Defaults to shared_queue.
+            /// under two_choices each worker takes from its own queue, so producers and consumers spread over many queues instead of contending on one. A bulk add is split into a chunk per active worker, each chunk placed by its own two choices.
+            /// idle workers look in the other workers' queues only every few attempts, and always before parking, so queued work is never stranded; try_get_task looks in all of them.
+            /// switching mode is safe at any time: tasks already placed are still found
+            /// \remark suits many short, similar tasks. Placement balances queue lengths, not task durations, so a queue can lag behind another until its neighbours look in
+            void set_task_placement(task_placement_mode mode);
+
+            /// \brief get the mode set by set_task_placement
+            task_placement_mode task_placement() const;
+
+            /// \brief get the number of deadline tasks dropped so far
+            size_t dropped_task_count() const;
+
             /// \brief removes and returns a task if the task collection is nonzero.
-            /// this can be called publicly to allow threads outside the threadgroup to help perform its tasks (typically the thread which created the group in the first place)
+            /// this can be called publicly to allow threads outside the threadgroup to help perform its tasks (typically the thread which created the group in the first place).
+            /// tasks are looked for in order: deadline tasks, the shared queue, the tenant queues, the per-worker queues of two_choices placement, then the task sources. Called from a worker, its own queue is not preferred
             std::optional<task_type> try_get_task();
 
+            /// \brief removes and returns up to maxCount tasks: deadline tasks first, then the shared queue, taken in one bulk dequeue to amortise its cost over the batch,
+            /// then tenant tasks, tasks in the per-worker queues and task source chunks, taken one at a time as try_get_task takes them
+            std::vector<task_type> try_get_tasks(size_t maxCount);
+
+            /// \brief runs a task in place on the calling thread, as try_get_task but without moving the task out. Returns false if no task was available
+            /// \remark as with try_get_task, tasks run by the calling thread are not counted in completed_task_count, and an exception thrown by a task propagates to the caller
+            bool run_one();
+
+            /// \brief runs tasks in place on the calling thread until duration has elapsed, e.g. to donate a time budgeted slice of the main thread.
+            /// when there is no work the thread spins briefly, then sleeps until work is added or the time is up. A task that is running when the time is up is finished first
+            /// \return the number of tasks run
+            size_t run_for(clock_type::duration duration);
+
+            /// \brief runs tasks in place on the calling thread until stopCondition returns true, backing off as run_for does.
+            /// stopCondition is polled between tasks and at least every millisecond while sleeping. Unlike run_as_worker, the thread does not take a worker slot
+            /// \return the number of tasks run
+            size_t run_until(const stop_condition_type &stopCondition);
+
+            /// \brief adds a task that must be run by the specified thread of the group, e.g. one owning a thread affine resource.
+            /// the task is posted to the worker's mailbox, which the worker checks before the shared queues. Targeted tasks from the same submitting thread run in submission order; tasks from different threads may interleave in any order
+            /// \throws std::out_of_range if workerIndex is not less than thread_count()
+            void add_task_to(size_t workerIndex, task_type &&task);
+
+            /// \brief runs f exactly once on each of the group's threads, e.g. to flush or reset thread local state.
+            /// f is posted to a mailbox per thread, which each worker checks before looking for other work. Returns without waiting for f to run
+            /// \remark external threads attached via run_as_worker do not receive broadcasts. If the group has no threads, f is not run
+            void broadcast(const task_type &f, broadcast_mode mode = broadcast_mode::independent);
+
+            /// \brief attaches the calling thread to the group as a full worker until stopCondition returns true or the group is destroyed.
+            /// while attached the thread runs the same loop as the group's own threads: it is given a worker index, its work is recorded in worker_stats, and it parks when there is no work rather than spinning.
+            /// stopCondition is polled between tasks and at least every millisecond while parked.
+            /// \return the number of tasks run by the calling thread
+            /// \remark worker indices of external threads start at thread_count() and are reused once the thread detaches
+            size_t run_as_worker(const stop_condition_type &stopCondition);
+
+            /// \brief returns the index of the calling thread's worker if the calling thread is currently working for this group, otherwise empty.
+            /// indices of the group's own threads are [0, thread_count())
+            std::optional<size_t> current_worker_index() const;
+
+            /// \brief records the submission and run of every task subsequently added to the group, broadcasts aside, into recorder. A null recorder stops recording.
+            /// tasks already queued when the recorder changes are recorded (or not) according to the recorder at the time they were added
+            void set_trace_recorder(std::shared_ptr<task_trace_recorder> recorder);
+
+            /// \brief limits the group's threads that take work from the shared queues to the first count, e.g. to back off when extra threads only add contention.
+            /// threads at or above the limit park until it is raised, serving only tasks addressed to them via add_task_to or broadcast. Threads attached via run_as_worker are not limited.
+            /// the limit starts at thread_count(); see concurrency_controller for adjusting it automatically
+            /// \throws std::out_of_range if count exceeds thread_count()
+            void set_active_worker_count(size_t count);
+
+            /// \brief get the limit set by set_active_worker_count
+            size_t active_worker_count() const;
+
+            /// \brief stops the group's threads taking work, e.g. to free the CPU during a latency critical phase without destroying the group.
+            /// each thread finishes the task it is running, then blocks until resume without consuming CPU. Tasks, including mailbox tasks and broadcasts, are still accepted and run after resume.
+            /// returns without waiting for running tasks to finish. Threads attached via run_as_worker are not paused, and try_get_task still returns tasks.
+            /// destroying a paused group resumes it, so that its remaining tasks run
+            void pause();
+
+            /// \brief lets the threads of a paused group take work again
+            void resume();
+
+            /// \brief true between pause and resume
+            bool is_paused() const;
+
+            /// \brief get the number of tasks completed by workers, including external threads attached via run_as_worker, but not tasks returned by try_get_task
+            /// \remark acquires a lock, as external threads may be attaching concurrently
+            size_t completed_task_count() const;
+
+            /// \brief returns counters for every worker slot, including slots used by external threads
+            /// \remark acquires a lock, as external threads may be attaching concurrently
+            worker_stats_collection_type worker_stats() const;
+
             /// \brief supports move semantics
             thread_group &operator=(thread_group &&b);
             /// \brief supports move semantics
@@ -63,6 +334,14 @@ namespace jfc
             /// \brief constructs a threadgroup with the specified number of threads.
             thread_group(size_t threadNumber);
 
+            /// \brief constructs a threadgroup with the specified number of threads, created with the specified attributes.
+            /// waits until every thread has applied the attributes, so thread_ids is complete on return
+            /// \throws std::invalid_argument if nice or realtime_priority is out of range
+            /// \throws std::system_error if a thread cannot be created or given the attributes, e.g. the fifo policy without privileges
+            thread_group(size_t threadNumber, const thread_attributes_type &attributes);
+            /// \overload
+            thread_group(size_t threadNumber, const thread_attributes_type &attributes, const memory_attributes_type &memory);
+
             /// \brief construct a thread group of size std::thread::hardware_concurrency() -1
             ///
             /// hardware_concurrency is a hint provided by the implementation about the # of threads that can be executed simultaneously on the hardware. The significance of a group of this size is that it represents a group that should be able to
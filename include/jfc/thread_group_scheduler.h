@@ -0,0 +1,581 @@
+#ifndef JFC_THREAD_GROUP_SCHEDULER_H
+#define JFC_THREAD_GROUP_SCHEDULER_H
+
+#include <jfc/thread_group.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// \brief a minimal sender/receiver interface in the style of P2300 (std::execution), and a scheduler modelling it on thread_group.
+/// the interface is the subset needed to compose work on a group without std::function per step:
+/// - a receiver has member functions set_value(values...), set_error(std::exception_ptr) and set_stopped()
+/// - a sender has a member type value_types (a std::tuple of the values it completes with), a member function connect(receiver) callable on an rvalue,
+///   returning an operation state, and a member function completion_group() returning the group it completes on, or nullptr
+/// - an operation state has a member function start(), and is neither copyable nor movable
+///
+/// each adaptor's operation state contains its predecessor's, so a whole chain is a single object, typically on the stack of sync_wait.
+/// the only task the group stores per step is a functor holding a pointer to the operation state, small enough for std::function to store inline.
+/// \code
+/// auto [sum] = *sync_wait(schedule(group)
+///     | then([]() { return load(); })
+///     | bulk(rows, [](size_t row, data &d) { process(d, row); })
+///     | then([](data &&d) { return total(d); }));
+/// \endcode
+namespace jfc::execution
+{
+    /// \brief delivers values to a receiver
+    template<class receiver_type, class... value_types>
+    void set_value(receiver_type &receiver, value_types &&...values)
+    {
+        receiver.set_value(std::forward<value_types>(values)...);
+    }
+
+    /// \brief delivers an error to a receiver
+    template<class receiver_type>
+    void set_error(receiver_type &receiver, std::exception_ptr error) noexcept
+    {
+        receiver.set_error(std::move(error));
+    }
+
+    /// \brief tells a receiver that the work was cancelled
+    template<class receiver_type>
+    void set_stopped(receiver_type &receiver) noexcept
+    {
+        receiver.set_stopped();
+    }
+
+    /// \brief connects a sender to a receiver, returning the operation state
+    template<class sender_type, class receiver_type>
+    auto connect(sender_type &&sender, receiver_type &&receiver)
+    {
+        static_assert(!std::is_lvalue_reference<sender_type>::value, "senders are consumed by connect, pass an rvalue");
+
+        return std::move(sender).connect(std::forward<receiver_type>(receiver));
+    }
+
+    /// \brief starts an operation
+    template<class operation_type>
+    void start(operation_type &operation) noexcept
+    {
+        operation.start();
+    }
+
+    /// \brief alias for the tuple of values a sender completes with
+    template<class sender_type>
+    using sender_value_types_t = typename std::decay<sender_type>::type::value_types;
+
+    namespace detail
+    {
+        /// \brief delivers the values held in a tuple to a receiver, delivering an error instead if doing so throws
+        template<class receiver_type, class tuple_type>
+        void set_value_from_tuple(receiver_type &receiver, tuple_type &&values) noexcept
+        {
+            try
+            {
+                std::apply([&receiver](auto &&...values)
+                {
+                    execution::set_value(receiver, std::forward<decltype(values)>(values)...);
+                }, std::forward<tuple_type>(values));
+            }
+            catch (...)
+            {
+                execution::set_error(receiver, std::current_exception());
+            }
+        }
+
+        /// \brief the operation states of the adaptors refer to themselves from tasks and receivers, so they are pinned
+        struct immovable
+        {
+            immovable() = default;
+            immovable(const immovable &) = delete;
+            immovable &operator=(const immovable &) = delete;
+        };
+    }
+
+    /// \brief sender completing with no values on one of a group's workers, see schedule
+    class schedule_sender final
+    {
+            thread_group *m_pGroup;
+
+        public:
+            using value_types = std::tuple<>;
+
+            template<class receiver_type>
+            class operation final : detail::immovable
+            {
+                    thread_group *m_pGroup;
+
+                    receiver_type m_Receiver;
+
+                public:
+                    /// \brief adds a task completing the receiver. The task captures only this operation's address
+                    void start() noexcept
+                    {
+                        try
+                        {
+                            m_pGroup->add_tasks([this]()
+                            {
+                                detail::set_value_from_tuple(m_Receiver, std::tuple<>());
+                            });
+                        }
+                        catch (...)
+                        {
+                            execution::set_error(m_Receiver, std::current_exception());
+                        }
+                    }
+
+                    operation(thread_group *pGroup, receiver_type receiver)
+                    : m_pGroup(pGroup)
+                    , m_Receiver(std::move(receiver))
+                    {}
+            };
+
+            template<class receiver_type>
+            operation<typename std::decay<receiver_type>::type> connect(receiver_type &&receiver) &&
+            {
+                return {m_pGroup, std::forward<receiver_type>(receiver)};
+            }
+
+            thread_group *completion_group() const { return m_pGroup; }
+
+            explicit schedule_sender(thread_group &group)
+            : m_pGroup(&group)
+            {}
+    };
+
+    /// \brief scheduler whose execution resources are the workers of a thread_group
+    class thread_group_scheduler final
+    {
+            thread_group *m_pGroup;
+
+        public:
+            /// \brief returns a sender that completes on one of the group's workers
+            schedule_sender schedule() const { return schedule_sender(*m_pGroup); }
+
+            thread_group &group() const { return *m_pGroup; }
+
+            bool operator==(const thread_group_scheduler &b) const { return m_pGroup == b.m_pGroup; }
+            bool operator!=(const thread_group_scheduler &b) const { return m_pGroup != b.m_pGroup; }
+
+            explicit thread_group_scheduler(thread_group &group)
+            : m_pGroup(&group)
+            {}
+    };
+
+    /// \brief returns a scheduler for the group
+    inline thread_group_scheduler get_scheduler(thread_group &group)
+    {
+        return thread_group_scheduler(group);
+    }
+
+    /// \brief returns a sender that completes on one of the scheduler's workers
+    inline schedule_sender schedule(const thread_group_scheduler &scheduler)
+    {
+        return scheduler.schedule();
+    }
+    /// \overload
+    inline schedule_sender schedule(thread_group &group)
+    {
+        return schedule_sender(group);
+    }
+
+    /// \brief sender completing immediately, on the thread that starts it, with the given values
+    template<class... value_type_list>
+    class just_sender final
+    {
+            std::tuple<value_type_list...> m_Values;
+
+        public:
+            using value_types = std::tuple<value_type_list...>;
+
+            template<class receiver_type>
+            class operation final : detail::immovable
+            {
+                    std::tuple<value_type_list...> m_Values;
+
+                    receiver_type m_Receiver;
+
+                public:
+                    void start() noexcept { detail::set_value_from_tuple(m_Receiver, std::move(m_Values)); }
+
+                    operation(std::tuple<value_type_list...> &&values, receiver_type receiver)
+                    : m_Values(std::move(values))
+                    , m_Receiver(std::move(receiver))
+                    {}
+            };
+
+            template<class receiver_type>
+            operation<typename std::decay<receiver_type>::type> connect(receiver_type &&receiver) &&
+            {
+                return {std::move(m_Values), std::forward<receiver_type>(receiver)};
+            }
+
+            thread_group *completion_group() const { return nullptr; }
+
+            explicit just_sender(value_type_list... values)
+            : m_Values(std::move(values)...)
+            {}
+    };
+
+    /// \brief returns a sender completing with values
+    template<class... value_type_list>
+    just_sender<typename std::decay<value_type_list>::type...> just(value_type_list &&...values)
+    {
+        return just_sender<typename std::decay<value_type_list>::type...>(std::forward<value_type_list>(values)...);
+    }
+
+    /// \brief sender completing with the result of a functor applied to its predecessor's values, on the thread the predecessor completed on, see then
+    template<class sender_type, class functor_type>
+    class then_sender final
+    {
+            template<class>
+            struct result_of;
+
+            template<class... value_type_list>
+            struct result_of<std::tuple<value_type_list...>>
+            {
+                using type = std::invoke_result_t<functor_type, value_type_list...>;
+            };
+
+            using result_type = typename result_of<sender_value_types_t<sender_type>>::type;
+
+            sender_type m_Sender;
+
+            functor_type m_Functor;
+
+        public:
+            using value_types = typename std::conditional<std::is_void<result_type>::value, std::tuple<>, std::tuple<result_type>>::type;
+
+            template<class receiver_type>
+            class receiver final
+            {
+                    receiver_type m_Receiver;
+
+                    functor_type m_Functor;
+
+                public:
+                    template<class... value_type_list>
+                    void set_value(value_type_list &&...values)
+                    {
+                        try
+                        {
+                            if constexpr (std::is_void<result_type>::value)
+                            {
+                                std::invoke(m_Functor, std::forward<value_type_list>(values)...);
+
+                                execution::set_value(m_Receiver);
+                            }
+                            else execution::set_value(m_Receiver, std::invoke(m_Functor, std::forward<value_type_list>(values)...));
+                        }
+                        catch (...)
+                        {
+                            execution::set_error(m_Receiver, std::current_exception());
+                        }
+                    }
+
+                    void set_error(std::exception_ptr error) noexcept { execution::set_error(m_Receiver, std::move(error)); }
+
+                    void set_stopped() noexcept { execution::set_stopped(m_Receiver); }
+
+                    receiver(receiver_type next, functor_type &&functor)
+                    : m_Receiver(std::move(next))
+                    , m_Functor(std::move(functor))
+                    {}
+            };
+
+            /// \brief the operation state is the predecessor's, connected to a receiver wrapping the functor
+            template<class receiver_type>
+            auto connect(receiver_type &&next) &&
+            {
+                return execution::connect(std::move(m_Sender), receiver<typename std::decay<receiver_type>::type>(std::forward<receiver_type>(next), std::move(m_Functor)));
+            }
+
+            thread_group *completion_group() const { return m_Sender.completion_group(); }
+
+            then_sender(sender_type sender, functor_type functor)
+            : m_Sender(std::move(sender))
+            , m_Functor(std::move(functor))
+            {}
+    };
+
+    /// \brief returns a sender that applies functor to the values of sender
+    template<class sender_type, class functor_type>
+    then_sender<typename std::decay<sender_type>::type, typename std::decay<functor_type>::type> then(sender_type &&sender, functor_type &&functor)
+    {
+        return {std::forward<sender_type>(sender), std::forward<functor_type>(functor)};
+    }
+
+    /// \brief sender running functor(i, values...) for every i in [0, shape), then completing with its predecessor's values, see bulk.
+    /// when the predecessor completes on a group, the index range is split into a few chunks per worker, each run as a task on that group; the last chunk to finish completes the receiver.
+    /// otherwise the range is run in order on the completing thread. If an invocation throws, the rest of its chunk is skipped and the first exception is delivered as an error once every chunk has finished
+    template<class sender_type, class functor_type>
+    class bulk_sender final
+    {
+            /// \brief number of chunks per worker, so that workers finishing early can take more work
+            static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+            sender_type m_Sender;
+
+            size_t m_Shape;
+
+            functor_type m_Functor;
+
+        public:
+            using value_types = sender_value_types_t<sender_type>;
+
+            template<class receiver_type>
+            class operation final : detail::immovable
+            {
+                    /// \brief receives the predecessor's values and fans them out
+                    struct inner_receiver_type
+                    {
+                        operation *m_pOperation;
+
+                        template<class... value_type_list>
+                        void set_value(value_type_list &&...values) { m_pOperation->run(std::forward<value_type_list>(values)...); }
+
+                        void set_error(std::exception_ptr error) noexcept { execution::set_error(m_pOperation->m_Receiver, std::move(error)); }
+
+                        void set_stopped() noexcept { execution::set_stopped(m_pOperation->m_Receiver); }
+                    };
+
+                    using inner_operation_type = decltype(execution::connect(std::declval<sender_type>(), std::declval<inner_receiver_type>()));
+
+                    receiver_type m_Receiver;
+
+                    functor_type m_Functor;
+
+                    const size_t m_Shape;
+
+                    thread_group *const m_pGroup;
+
+                    /// \brief the predecessor's values, kept for the invocations and then forwarded to the receiver
+                    std::optional<value_types> m_Values;
+
+                    size_t m_ChunkCount = 0;
+
+                    std::atomic<size_t> m_RemainingChunks;
+
+                    std::mutex m_ErrorMutex;
+
+                    std::exception_ptr m_Error;
+
+                    inner_operation_type m_Inner;
+
+                    void run_chunk(const size_t chunk) noexcept
+                    {
+                        try
+                        {
+                            const auto end = m_Shape * (chunk + 1) / m_ChunkCount;
+
+                            for (auto i = m_Shape * chunk / m_ChunkCount; i < end; ++i) std::apply([this, i](auto &...values)
+                            {
+                                std::invoke(m_Functor, i, values...);
+                            }, *m_Values);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(m_ErrorMutex);
+
+                            if (!m_Error) m_Error = std::current_exception();
+                        }
+
+                        if (m_RemainingChunks.fetch_sub(1, std::memory_order_acq_rel) == 1) complete();
+                    }
+
+                    void complete() noexcept
+                    {
+                        if (m_Error) execution::set_error(m_Receiver, m_Error);
+                        else detail::set_value_from_tuple(m_Receiver, std::move(*m_Values));
+                    }
+
+                    template<class... value_type_list>
+                    void run(value_type_list &&...values)
+                    {
+                        m_Values.emplace(std::forward<value_type_list>(values)...);
+
+                        m_ChunkCount = m_pGroup ? std::min(m_Shape, (m_pGroup->thread_count() + 1) * CHUNKS_PER_THREAD) : 1;
+
+                        if (!m_ChunkCount)
+                        {
+                            complete();
+
+                            return;
+                        }
+
+                        m_RemainingChunks.store(m_ChunkCount, std::memory_order_relaxed);
+
+                        if (!m_pGroup)
+                        {
+                            run_chunk(0);
+
+                            return;
+                        }
+
+                        std::vector<thread_group::task_type> tasks;
+
+                        tasks.reserve(m_ChunkCount);
+
+                        // each task holds the operation's address and a chunk index, small enough for std::function to store inline
+                        for (size_t chunk(0); chunk < m_ChunkCount; ++chunk) tasks.push_back([this, chunk]() { run_chunk(chunk); });
+
+                        m_pGroup->add_tasks(std::move(tasks));
+                    }
+
+                public:
+                    void start() noexcept { execution::start(m_Inner); }
+
+                    operation(sender_type &&sender, receiver_type receiver, functor_type &&functor, const size_t shape)
+                    : m_Receiver(std::move(receiver))
+                    , m_Functor(std::move(functor))
+                    , m_Shape(shape)
+                    , m_pGroup(sender.completion_group())
+                    , m_RemainingChunks(0)
+                    , m_Inner(execution::connect(std::move(sender), inner_receiver_type{this}))
+                    {}
+            };
+
+            template<class receiver_type>
+            operation<typename std::decay<receiver_type>::type> connect(receiver_type &&receiver) &&
+            {
+                return {std::move(m_Sender), std::forward<receiver_type>(receiver), std::move(m_Functor), m_Shape};
+            }
+
+            thread_group *completion_group() const { return m_Sender.completion_group(); }
+
+            bulk_sender(sender_type sender, const size_t shape, functor_type functor)
+            : m_Sender(std::move(sender))
+            , m_Shape(shape)
+            , m_Functor(std::move(functor))
+            {}
+    };
+
+    /// \brief returns a sender that runs functor(i, values...) for every i in [0, shape) across the workers of the group sender completes on
+    template<class sender_type, class functor_type>
+    bulk_sender<typename std::decay<sender_type>::type, typename std::decay<functor_type>::type> bulk(sender_type &&sender, const size_t shape, functor_type &&functor)
+    {
+        return {std::forward<sender_type>(sender), shape, std::forward<functor_type>(functor)};
+    }
+
+    namespace detail
+    {
+        template<class functor_type>
+        struct then_closure
+        {
+            functor_type m_Functor;
+        };
+
+        template<class functor_type>
+        struct bulk_closure
+        {
+            size_t m_Shape;
+
+            functor_type m_Functor;
+        };
+    }
+
+    /// \brief returns an adaptor applying then to the sender on the left of operator|
+    template<class functor_type>
+    detail::then_closure<typename std::decay<functor_type>::type> then(functor_type &&functor)
+    {
+        return {std::forward<functor_type>(functor)};
+    }
+
+    /// \brief returns an adaptor applying bulk to the sender on the left of operator|
+    template<class functor_type>
+    detail::bulk_closure<typename std::decay<functor_type>::type> bulk(const size_t shape, functor_type &&functor)
+    {
+        return {shape, std::forward<functor_type>(functor)};
+    }
+
+    template<class sender_type, class functor_type>
+    auto operator|(sender_type &&sender, detail::then_closure<functor_type> closure)
+    {
+        return then(std::forward<sender_type>(sender), std::move(closure.m_Functor));
+    }
+
+    template<class sender_type, class functor_type>
+    auto operator|(sender_type &&sender, detail::bulk_closure<functor_type> closure)
+    {
+        return bulk(std::forward<sender_type>(sender), closure.m_Shape, std::move(closure.m_Functor));
+    }
+
+    namespace detail
+    {
+        template<class value_types>
+        struct sync_wait_state
+        {
+            std::optional<value_types> m_Values;
+
+            std::exception_ptr m_Error;
+
+            std::atomic<bool> m_IsDone = false;
+        };
+
+        template<class value_types>
+        struct sync_wait_receiver
+        {
+            sync_wait_state<value_types> *m_pState;
+
+            template<class... value_type_list>
+            void set_value(value_type_list &&...values)
+            {
+                m_pState->m_Values.emplace(std::forward<value_type_list>(values)...);
+
+                m_pState->m_IsDone.store(true, std::memory_order_release);
+            }
+
+            void set_error(std::exception_ptr error) noexcept
+            {
+                m_pState->m_Error = std::move(error);
+
+                m_pState->m_IsDone.store(true, std::memory_order_release);
+            }
+
+            void set_stopped() noexcept { m_pState->m_IsDone.store(true, std::memory_order_release); }
+        };
+    }
+
+    /// \brief starts the sender and blocks until it completes, returning its values, or nothing if it was stopped. An error is rethrown.
+    /// while waiting, the calling thread helps with the tasks of the group the sender completes on, so sync_wait may be called from within a task
+    template<class sender_type>
+    std::optional<sender_value_types_t<sender_type>> sync_wait(sender_type sender)
+    {
+        using value_types = sender_value_types_t<sender_type>;
+
+        detail::sync_wait_state<value_types> state;
+
+        const auto pGroup = sender.completion_group();
+
+        auto operation = execution::connect(std::move(sender), detail::sync_wait_receiver<value_types>{&state});
+
+        execution::start(operation);
+
+        while (!state.m_IsDone.load(std::memory_order_acquire))
+        {
+            if (pGroup) if (auto task = pGroup->try_get_task())
+            {
+                (*task)();
+
+                continue;
+            }
+
+            std::this_thread::yield();
+        }
+
+        if (state.m_Error) std::rethrow_exception(state.m_Error);
+
+        return std::move(state.m_Values);
+    }
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include <jfc/concurrency_controller.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace jfc
+{
+    size_t hill_climbing_policy::next_worker_count(const size_t currentWorkerCount, const double throughput)
+    {
+        if (m_HasSample && throughput < m_LastThroughput * (1 - m_Options.noise_threshold)) m_Direction = -m_Direction;
+
+        m_LastThroughput = throughput;
+        m_HasSample = true;
+
+        const auto current = std::clamp(currentWorkerCount, m_Options.min_worker_count, m_Options.max_worker_count);
+
+        // at a bound, turn around rather than stand still, so the search keeps probing
+        if (m_Direction > 0 && current == m_Options.max_worker_count) m_Direction = -1;
+        else if (m_Direction < 0 && current == m_Options.min_worker_count) m_Direction = 1;
+
+        if (m_Options.min_worker_count == m_Options.max_worker_count) return current;
+
+        return m_Direction > 0 ? current + 1 : current - 1;
+    }
+
+    hill_climbing_policy::hill_climbing_policy(const options_type &options)
+    : m_Options(options)
+    {
+        if (options.min_worker_count > options.max_worker_count) throw std::invalid_argument("jfc::hill_climbing_policy: min worker count exceeds max worker count");
+
+        if (options.noise_threshold < 0) throw std::invalid_argument("jfc::hill_climbing_policy: noise threshold must not be negative");
+    }
+
+    static hill_climbing_policy::options_type cap_options(hill_climbing_policy::options_type options, const thread_group &group)
+    {
+        if (!group.thread_count()) throw std::invalid_argument("jfc::concurrency_controller: the group has no threads to control");
+
+        options.max_worker_count = std::min(options.max_worker_count, group.thread_count());
+
+        return options;
+    }
+
+    void concurrency_controller::sample()
+    {
+        auto last_count = m_Group.completed_task_count();
+
+        auto last_time = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+
+        while (!m_StopCondition.wait_for(lock, m_Interval, [this]() { return m_IsStopped; }))
+        {
+            const auto count = m_Group.completed_task_count();
+
+            const auto now = std::chrono::steady_clock::now();
+
+            if (count == last_count)
+            {
+                last_time = now;
+
+                continue;
+            }
+
+            const auto throughput = (count - last_count) / std::chrono::duration<double>(now - last_time).count();
+
+            m_Group.set_active_worker_count(m_Policy.next_worker_count(m_Group.active_worker_count(), throughput));
+
+            last_count = count;
+            last_time = now;
+        }
+    }
+
+    concurrency_controller::concurrency_controller(thread_group &group, const hill_climbing_policy::options_type options, const interval_type interval)
+    : m_Group(group)
+    , m_Policy(cap_options(options, group))
+    , m_Interval(interval)
+    , m_Thread([this]() { sample(); })
+    {}
+
+    concurrency_controller::~concurrency_controller()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            m_IsStopped = true;
+        }
+
+        m_StopCondition.notify_all();
+
+        m_Thread.join();
+
+        m_Group.set_active_worker_count(m_Group.thread_count());
+    }
+}
@@ -0,0 +1,424 @@
+#include <jfc/fiber_job_system.h>
+
+#ifdef JFC_FIBERS_SUPPORTED
+
+#include <moody/concurrentqueue.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+/// \brief saves the callee saved registers of the running context on its stack, stores its stack pointer in *pFromStackPointer,
+/// then switches to the stack at pToStackPointer and restores the context saved there
+extern "C" void jfc_fiber_switch(void **pFromStackPointer, void *pToStackPointer);
+
+/// \brief first code run on a new fiber stack: calls the entry function left in a callee saved register with the argument left in another
+extern "C" void jfc_fiber_trampoline();
+
+#if defined(__x86_64__)
+
+// System V: rbx, rbp, r12-r15, mxcsr and the x87 control word are callee saved
+asm(R"(
+    .pushsection .text
+    .globl jfc_fiber_switch
+    .hidden jfc_fiber_switch
+    .type jfc_fiber_switch, %function
+jfc_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size jfc_fiber_switch, .-jfc_fiber_switch
+
+    .globl jfc_fiber_trampoline
+    .hidden jfc_fiber_trampoline
+    .type jfc_fiber_trampoline, %function
+jfc_fiber_trampoline:
+    movq %r12, %rdi
+    callq *%r13
+    ud2
+    .size jfc_fiber_trampoline, .-jfc_fiber_trampoline
+    .popsection
+)");
+
+#elif defined(__aarch64__)
+
+// AAPCS64: x19-x29, the link register x30 and the low halves of v8-v15 are callee saved
+asm(R"(
+    .pushsection .text
+    .globl jfc_fiber_switch
+    .hidden jfc_fiber_switch
+    .type jfc_fiber_switch, %function
+jfc_fiber_switch:
+    sub sp, sp, #176
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #176
+    ret
+    .size jfc_fiber_switch, .-jfc_fiber_switch
+
+    .globl jfc_fiber_trampoline
+    .hidden jfc_fiber_trampoline
+    .type jfc_fiber_trampoline, %function
+jfc_fiber_trampoline:
+    mov x0, x19
+    blr x20
+    brk #0
+    .size jfc_fiber_trampoline, .-jfc_fiber_trampoline
+    .popsection
+)");
+
+#endif
+
+namespace jfc
+{
+    struct fiber_job_system::fiber_type
+    {
+        /// \brief what the fiber was doing when it last switched back to the thread that resumed it
+        enum class state_type
+        {
+            finished,
+            waiting
+        };
+
+        /// \brief stack pointer saved by the last switch away from the fiber
+        void *m_StackPointer = nullptr;
+
+        /// \brief the mapping holding the stack, including the guard page
+        void *m_pMapping = nullptr;
+
+        size_t m_MappingSize = 0;
+
+        /// \brief where the thread currently running the fiber saved its own stack pointer. Set each time the fiber is resumed
+        void **m_pResumerStackPointer = nullptr;
+
+        state_type m_State = state_type::finished;
+
+        job_type m_Job;
+
+        counter *m_pCounter = nullptr;
+
+        /// \brief the counter and value the fiber is waiting for, valid while m_State is waiting
+        counter *m_pWaitCounter = nullptr;
+
+        size_t m_WaitValue = 0;
+    };
+
+    struct fiber_job_system::shared_data_type
+    {
+        thread_group &m_Group;
+
+        std::vector<fiber_type> m_Fibers;
+
+        /// \brief fibers not currently running a job
+        moodycamel::ConcurrentQueue<fiber_type *> m_FreeFibers;
+
+        /// \brief the fiber running on the calling thread, if any
+        static thread_local fiber_type *t_pCurrentFiber;
+
+        shared_data_type(thread_group &group, const size_t fiberCount)
+        : m_Group(group)
+        , m_Fibers(fiberCount)
+        , m_FreeFibers(fiberCount)
+        {}
+
+        ~shared_data_type()
+        {
+            for (auto &fiber : m_Fibers) if (fiber.m_pMapping) munmap(fiber.m_pMapping, fiber.m_MappingSize);
+        }
+
+        /// \brief body of every fiber: runs its job, then hands control back to the thread that resumed it, awaiting the next job
+        static void fiber_main(void *pArgument)
+        {
+            auto &fiber = *static_cast<fiber_type *>(pArgument);
+
+            for (;;)
+            {
+                fiber.m_Job();
+
+                fiber.m_Job = nullptr;
+
+                fiber.m_State = fiber_type::state_type::finished;
+
+                jfc_fiber_switch(&fiber.m_StackPointer, *fiber.m_pResumerStackPointer);
+            }
+        }
+
+        /// \brief maps the stack of a fiber, with a guard page below it, and lays out an initial context that enters fiber_main via the trampoline
+        static void initialize_fiber(fiber_type &fiber, const size_t stackSize)
+        {
+            const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+            const auto usable_size = ((stackSize + page_size - 1) / page_size) * page_size;
+
+            fiber.m_MappingSize = usable_size + page_size;
+
+            fiber.m_pMapping = mmap(nullptr, fiber.m_MappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+
+            if (fiber.m_pMapping == MAP_FAILED)
+            {
+                fiber.m_pMapping = nullptr;
+
+                throw std::bad_alloc();
+            }
+
+            mprotect(fiber.m_pMapping, page_size, PROT_NONE);
+
+            auto top = reinterpret_cast<std::uintptr_t *>(static_cast<char *>(fiber.m_pMapping) + fiber.m_MappingSize);
+
+            const auto entry = reinterpret_cast<std::uintptr_t>(&fiber_main);
+            const auto argument = reinterpret_cast<std::uintptr_t>(&fiber);
+            const auto trampoline = reinterpret_cast<std::uintptr_t>(&jfc_fiber_trampoline);
+
+#if defined(__x86_64__)
+            // mirrors the frame pushed by jfc_fiber_switch: the return address is placed so that the stack is 16 byte aligned at the trampoline's call
+            top[-1] = trampoline;
+            top[-2] = 0;        // rbp
+            top[-3] = 0;        // rbx
+            top[-4] = argument; // r12
+            top[-5] = entry;    // r13
+            top[-6] = 0;        // r14
+            top[-7] = 0;        // r15
+            top[-8] = 0x037F00001F80; // default x87 control word and mxcsr
+
+            fiber.m_StackPointer = top - 8;
+#elif defined(__aarch64__)
+            auto frame = top - 22;
+
+            std::fill(frame, top, 0);
+
+            frame[0] = argument;    // x19
+            frame[1] = entry;       // x20
+            frame[11] = trampoline; // x30
+
+            fiber.m_StackPointer = frame;
+#endif
+        }
+
+        void release_fiber(fiber_type &fiber)
+        {
+            m_FreeFibers.enqueue(&fiber);
+        }
+
+        /// \brief decrements a counter, resubmitting the fibers whose wait it satisfies.
+        /// the counter is decremented under its lock and not touched after the lock is released: a waiter that sees the new value may destroy the counter as soon as it can take the lock
+        static void decrement(const std::shared_ptr<shared_data_type> &shared, counter &c)
+        {
+            std::vector<fiber_type *> ready;
+
+            {
+                std::lock_guard<std::mutex> lock(c.m_Mutex);
+
+                const auto value = c.m_Value.fetch_sub(1) - 1;
+
+                auto waiters_end = std::partition(c.m_Waiters.begin(), c.m_Waiters.end(), [value](const counter::waiter_type &waiter)
+                {
+                    return waiter.second < value;
+                });
+
+                for (auto i = waiters_end; i != c.m_Waiters.end(); ++i) ready.push_back(i->first);
+
+                c.m_Waiters.erase(waiters_end, c.m_Waiters.end());
+            }
+
+            for (auto pFiber : ready) submit_resume(shared, *pFiber);
+        }
+
+        /// \brief adds a task to the group that resumes the fiber
+        static void submit_resume(const std::shared_ptr<shared_data_type> &shared, fiber_type &fiber)
+        {
+            shared->m_Group.add_tasks([shared, pFiber = &fiber]()
+            {
+                resume(shared, *pFiber);
+            });
+        }
+
+        /// \brief switches the calling thread onto the fiber until the fiber finishes its job or waits.
+        /// bookkeeping that must not happen while the fiber's stack is still in use (releasing it, registering it as a waiter) happens here, once back on the calling thread's stack
+        static void resume(const std::shared_ptr<shared_data_type> &shared, fiber_type &fiber)
+        {
+            void *resumer_stack_pointer;
+
+            fiber.m_pResumerStackPointer = &resumer_stack_pointer;
+
+            // saved and restored since a job may itself run tasks that resume fibers
+            const auto pPreviousFiber = t_pCurrentFiber;
+
+            t_pCurrentFiber = &fiber;
+
+            jfc_fiber_switch(&resumer_stack_pointer, fiber.m_StackPointer);
+
+            t_pCurrentFiber = pPreviousFiber;
+
+            if (fiber.m_State == fiber_type::state_type::finished)
+            {
+                auto pCounter = fiber.m_pCounter;
+
+                fiber.m_pCounter = nullptr;
+
+                shared->release_fiber(fiber);
+
+                if (pCounter) decrement(shared, *pCounter);
+            }
+            else
+            {
+                auto &c = *fiber.m_pWaitCounter;
+
+                bool is_ready;
+
+                {
+                    std::lock_guard<std::mutex> lock(c.m_Mutex);
+
+                    is_ready = c.m_Value.load() <= fiber.m_WaitValue;
+
+                    if (!is_ready) c.m_Waiters.push_back({&fiber, fiber.m_WaitValue});
+                }
+
+                if (is_ready) submit_resume(shared, fiber);
+            }
+        }
+
+        /// \brief adds a task to the group that starts the job on a free fiber.
+        /// if every fiber is busy the task puts itself back in the queue, to be retried once other jobs have progressed
+        static void submit_job(const std::shared_ptr<shared_data_type> &shared, job_type &&job, counter *pCounter)
+        {
+            shared->m_Group.add_tasks([shared, job = std::move(job), pCounter]() mutable
+            {
+                fiber_type *pFiber;
+
+                if (!shared->m_FreeFibers.try_dequeue(pFiber))
+                {
+                    submit_job(shared, std::move(job), pCounter);
+
+                    std::this_thread::yield();
+
+                    return;
+                }
+
+                pFiber->m_Job = std::move(job);
+                pFiber->m_pCounter = pCounter;
+
+                resume(shared, *pFiber);
+            });
+        }
+    };
+
+    thread_local fiber_job_system::fiber_type *fiber_job_system::shared_data_type::t_pCurrentFiber = nullptr;
+
+    fiber_job_system::counter::counter(const size_t value)
+    : m_Value(value)
+    {}
+
+    size_t fiber_job_system::counter::value() const
+    {
+        return m_Value.load();
+    }
+
+    void fiber_job_system::run_jobs(std::vector<job_type> &&jobs, counter *pCounter)
+    {
+        if (pCounter) pCounter->m_Value.fetch_add(jobs.size());
+
+        for (auto &job : jobs) shared_data_type::submit_job(m_SharedData, std::move(job), pCounter);
+    }
+    void fiber_job_system::run_jobs(job_type &&job, counter *pCounter)
+    {
+        if (pCounter) pCounter->m_Value.fetch_add(1);
+
+        shared_data_type::submit_job(m_SharedData, std::move(job), pCounter);
+    }
+
+    /// \brief true if the counter is at or below value. Read under the counter's lock, so that a decrement that reached the value has released the counter before the caller returns and perhaps destroys it
+    static bool is_counter_reached(std::mutex &mutex, const std::atomic<size_t> &counterValue, const size_t value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        return counterValue.load() <= value;
+    }
+
+    void fiber_job_system::wait_for_counter(counter &c, const size_t value)
+    {
+        if (is_counter_reached(c.m_Mutex, c.m_Value, value)) return;
+
+        if (auto pFiber = shared_data_type::t_pCurrentFiber)
+        {
+            pFiber->m_State = fiber_type::state_type::waiting;
+            pFiber->m_pWaitCounter = &c;
+            pFiber->m_WaitValue = value;
+
+            // execution continues here once the counter has been reached, possibly on another thread
+            jfc_fiber_switch(&pFiber->m_StackPointer, *pFiber->m_pResumerStackPointer);
+
+            return;
+        }
+
+        // polled without the lock, then confirmed under it
+        while (c.m_Value.load() > value || !is_counter_reached(c.m_Mutex, c.m_Value, value))
+        {
+            if (auto task = m_SharedData->m_Group.try_get_task()) (*task)();
+            else std::this_thread::yield();
+        }
+    }
+
+    size_t fiber_job_system::fiber_count() const
+    {
+        return m_SharedData->m_Fibers.size();
+    }
+
+    fiber_job_system::fiber_job_system(thread_group &group, const size_t fiberCount, const size_t stackSize)
+    : m_SharedData(std::make_shared<shared_data_type>(group, fiberCount))
+    {
+        for (auto &fiber : m_SharedData->m_Fibers)
+        {
+            shared_data_type::initialize_fiber(fiber, stackSize);
+
+            m_SharedData->release_fiber(fiber);
+        }
+    }
+
+    // the stacks are unmapped with the shared data, once no task refers to them
+    fiber_job_system::~fiber_job_system() = default;
+}
+
+#endif
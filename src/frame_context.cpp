@@ -0,0 +1,80 @@
+#include <jfc/frame_context.h>
+
+#include <cstdint>
+#include <thread>
+
+namespace jfc
+{
+    void *frame_context::allocate_bytes(const size_t size, const size_t alignment)
+    {
+        const auto base = reinterpret_cast<std::uintptr_t>(m_Arena.get());
+
+        auto offset = m_Offset.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            const auto aligned = ((base + offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+
+            if (aligned + size > m_Capacity) throw std::bad_alloc();
+
+            if (m_Offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed)) return m_Arena.get() + aligned;
+        }
+    }
+
+    void frame_context::submit(task_node_header_type *const pNode)
+    {
+        m_OutstandingTaskCount.fetch_add(1, std::memory_order_relaxed);
+
+        m_Group.add_tasks([pNode]()
+        {
+            // released even if the task throws, so that end_frame does not wait on it forever. Holds the context, since running destroys the node
+            struct completion_guard
+            {
+                frame_context *m_pContext;
+
+                ~completion_guard() { m_pContext->m_OutstandingTaskCount.fetch_sub(1, std::memory_order_release); }
+            } guard{pNode->m_pContext};
+
+            pNode->m_pRun(pNode);
+        });
+    }
+
+    void frame_context::end_frame()
+    {
+        while (m_OutstandingTaskCount.load(std::memory_order_acquire))
+        {
+            if (auto task = m_Group.try_get_task()) (*task)();
+            else std::this_thread::yield();
+        }
+
+        m_Offset.store(0, std::memory_order_relaxed);
+    }
+
+    size_t frame_context::outstanding_task_count() const
+    {
+        return m_OutstandingTaskCount.load(std::memory_order_relaxed);
+    }
+
+    size_t frame_context::bytes_used() const
+    {
+        return m_Offset.load(std::memory_order_relaxed);
+    }
+
+    size_t frame_context::capacity() const
+    {
+        return m_Capacity;
+    }
+
+    frame_context::frame_context(thread_group &group, const size_t arenaSize)
+    : m_Group(group)
+    , m_Arena(new unsigned char[arenaSize])
+    , m_Capacity(arenaSize)
+    , m_Offset(0)
+    , m_OutstandingTaskCount(0)
+    {}
+
+    frame_context::~frame_context()
+    {
+        end_frame();
+    }
+}
@@ -0,0 +1,126 @@
+#include <jfc/huge_page_allocator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace jfc
+{
+    huge_page_region::huge_page_region(const size_t size)
+    : m_Size(std::max<size_t>((size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE, 1) * HUGE_PAGE_SIZE)
+    {
+#if defined(__linux__)
+        auto flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+#ifdef MAP_HUGE_SHIFT
+        // the default huge page size may be 1 GB, so 2 MB pages are asked for by name
+        flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+
+        auto p = ::mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+        if (p != MAP_FAILED)
+        {
+            m_pAddress = p;
+            m_Backing = backing_type::huge_pages;
+
+            return;
+        }
+
+        // over mapped by a huge page, so that an aligned range can be cut out of it and the rest returned
+        p = ::mmap(nullptr, m_Size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (p == MAP_FAILED) throw std::bad_alloc();
+
+        const auto begin = reinterpret_cast<std::uintptr_t>(p);
+        const auto aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(std::uintptr_t(HUGE_PAGE_SIZE) - 1);
+        const auto end = begin + m_Size + HUGE_PAGE_SIZE;
+
+        if (aligned != begin) ::munmap(p, aligned - begin);
+
+        if (end != aligned + m_Size) ::munmap(reinterpret_cast<void *>(aligned + m_Size), end - (aligned + m_Size));
+
+        m_pAddress = reinterpret_cast<void *>(aligned);
+
+#ifdef MADV_HUGEPAGE
+        if (!::madvise(m_pAddress, m_Size, MADV_HUGEPAGE)) m_Backing = backing_type::transparent_huge_pages;
+#endif
+#else
+        m_pAddress = ::operator new(m_Size, std::align_val_t(HUGE_PAGE_SIZE));
+
+        std::memset(m_pAddress, 0, m_Size);
+#endif
+    }
+
+    huge_page_region::~huge_page_region()
+    {
+#if defined(__linux__)
+        ::munmap(m_pAddress, m_Size);
+#else
+        ::operator delete(m_pAddress, std::align_val_t(HUGE_PAGE_SIZE));
+#endif
+    }
+
+    void *huge_page_arena::try_allocate(const size_t size, const size_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (!m_Regions.empty())
+        {
+            const auto &region = *m_Regions.back();
+
+            const auto base = reinterpret_cast<std::uintptr_t>(region.data());
+
+            const auto aligned = ((base + m_Offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+
+            if (aligned <= region.size() && size <= region.size() - aligned)
+            {
+                m_Offset = aligned + size;
+
+                return static_cast<unsigned char *>(region.data()) + aligned;
+            }
+        }
+
+        // regions are huge page aligned, so the allocation starts the new region. The rest of the previous one is left unused
+        try
+        {
+            m_Regions.push_back(std::make_unique<huge_page_region>(size));
+        }
+        catch (const std::bad_alloc &)
+        {
+            return nullptr;
+        }
+
+        m_Offset = size;
+
+        return m_Regions.back()->data();
+    }
+
+    size_t huge_page_arena::capacity() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        size_t capacity(0);
+
+        for (const auto &pRegion : m_Regions) capacity += pRegion->size();
+
+        return capacity;
+    }
+
+    huge_page_region::backing_type huge_page_arena::backing() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        if (m_Regions.empty()) return huge_page_region::backing_type::normal_pages;
+
+        auto backing = huge_page_region::backing_type::huge_pages;
+
+        for (const auto &pRegion : m_Regions) backing = std::max(backing, pRegion->backing());
+
+        return backing;
+    }
+}
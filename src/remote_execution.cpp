@@ -0,0 +1,687 @@
+#include <jfc/remote_execution.h>
+
+#ifdef JFC_REMOTE_EXECUTION_SUPPORTED
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace jfc
+{
+    /// \brief first word of every frame, so that a stray connection is dropped rather than misread
+    static constexpr std::uint32_t FRAME_MAGIC = 0x6a666372;
+
+    /// \brief largest frame body accepted, to bound the memory a malformed frame can claim
+    static constexpr std::uint64_t MAX_FRAME_BODY_SIZE = 64 * 1024 * 1024;
+
+    /// \brief status tags of response records
+    enum response_status : std::uint32_t
+    {
+        RESPONSE_SUCCEEDED = 0,
+        RESPONSE_FAILED = 1
+    };
+
+    /// \brief a frame is a frame_header followed by record_count records, each a record_header followed by its payload.
+    /// a request's tag is the function id, a response's tag its response_status. Fields are in host byte order
+    struct frame_header
+    {
+        std::uint32_t magic;
+        std::uint32_t record_count;
+        std::uint64_t body_size;
+    };
+
+    struct record_header
+    {
+        std::uint64_t id;
+        std::uint32_t tag;
+        std::uint32_t payload_size;
+    };
+
+    static_assert(remote_executor::MAX_PAYLOAD_SIZE + sizeof(record_header) == MAX_FRAME_BODY_SIZE, "a record of the largest payload must fill a frame exactly");
+
+    struct record_type
+    {
+        std::uint64_t id;
+        std::uint32_t tag;
+        std::string payload;
+    };
+
+    static bool write_all(const int fd, const char *data, size_t size)
+    {
+        while (size)
+        {
+            const auto written = ::send(fd, data, size, MSG_NOSIGNAL);
+
+            if (written < 0)
+            {
+                if (errno == EINTR) continue;
+
+                return false;
+            }
+
+            data += written;
+            size -= written;
+        }
+
+        return true;
+    }
+
+    static bool read_all(const int fd, char *data, size_t size)
+    {
+        while (size)
+        {
+            const auto got = ::recv(fd, data, size, 0);
+
+            if (got < 0 && errno == EINTR) continue;
+
+            if (got <= 0) return false;
+
+            data += got;
+            size -= got;
+        }
+
+        return true;
+    }
+
+    /// \brief writes records [first, last) as one frame, or as several if they would not fit MAX_FRAME_BODY_SIZE together.
+    /// each payload must be at most remote_executor::MAX_PAYLOAD_SIZE, so that every record fits a frame on its own
+    static bool write_frames(const int fd, std::vector<record_type>::const_iterator first, const std::vector<record_type>::const_iterator last)
+    {
+        std::string frame;
+
+        while (first != last)
+        {
+            frame.assign(sizeof(frame_header), '\0');
+
+            std::uint32_t count(0);
+
+            for (; first != last && (!count || frame.size() - sizeof(frame_header) + sizeof(record_header) + first->payload.size() <= MAX_FRAME_BODY_SIZE); ++first, ++count)
+            {
+                const record_header header{first->id, first->tag, static_cast<std::uint32_t>(first->payload.size())};
+
+                frame.append(reinterpret_cast<const char *>(&header), sizeof(header));
+                frame.append(first->payload);
+            }
+
+            const frame_header header{FRAME_MAGIC, count, frame.size() - sizeof(frame_header)};
+
+            std::memcpy(&frame[0], &header, sizeof(header));
+
+            if (!write_all(fd, frame.data(), frame.size())) return false;
+        }
+
+        return true;
+    }
+
+    /// \brief reads one frame into records, returns false on end of stream, error, or a malformed frame
+    static bool read_frame(const int fd, std::vector<record_type> &records)
+    {
+        frame_header header;
+
+        if (!read_all(fd, reinterpret_cast<char *>(&header), sizeof(header))) return false;
+
+        if (header.magic != FRAME_MAGIC || header.body_size > MAX_FRAME_BODY_SIZE) return false;
+
+        std::string body(header.body_size, '\0');
+
+        if (!read_all(fd, &body[0], body.size())) return false;
+
+        records.clear();
+        records.reserve(std::min<std::uint64_t>(header.record_count, body.size() / sizeof(record_header)));
+
+        size_t offset(0);
+
+        for (std::uint32_t i(0); i < header.record_count; ++i)
+        {
+            record_header record;
+
+            if (body.size() - offset < sizeof(record)) return false;
+
+            std::memcpy(&record, body.data() + offset, sizeof(record));
+
+            offset += sizeof(record);
+
+            if (body.size() - offset < record.payload_size) return false;
+
+            records.push_back({record.id, record.tag, body.substr(offset, record.payload_size)});
+
+            offset += record.payload_size;
+        }
+
+        return offset == body.size();
+    }
+
+    static sockaddr_un make_address(const std::string &socketPath, const char *owner)
+    {
+        sockaddr_un address{};
+
+        address.sun_family = AF_UNIX;
+
+        if (socketPath.size() >= sizeof(address.sun_path)) throw std::system_error(ENAMETOOLONG, std::generic_category(), std::string(owner) + ": socket path is too long");
+
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        return address;
+    }
+
+    struct remote_worker::shared_data_type
+    {
+        /// \brief state of one client connection, shared by its reader and writer threads and its running requests
+        struct connection_type
+        {
+            int m_Socket;
+
+            std::mutex m_Mutex;
+
+            /// \brief wakes the writer when responses are ready, and the reader when the window opens
+            std::condition_variable m_Condition;
+
+            std::vector<record_type> m_Responses;
+
+            size_t m_InFlight = 0;
+
+            bool m_IsReadDone = false;
+
+            std::atomic<bool> m_IsFinished = false;
+
+            std::thread m_Reader;
+
+            std::thread m_Writer;
+
+            connection_type(const int socket)
+            : m_Socket(socket)
+            {}
+        };
+
+        thread_group &m_Group;
+
+        const remote_function_registry m_Registry;
+
+        const std::string m_SocketPath;
+
+        const options_type m_Options;
+
+        int m_ListenSocket = -1;
+
+        std::atomic<size_t> m_CompletedRequestCount = 0;
+
+        std::atomic<bool> m_IsStopping = false;
+
+        std::mutex m_ConnectionsMutex;
+
+        std::vector<std::shared_ptr<connection_type>> m_Connections;
+
+        std::thread m_Acceptor;
+
+        shared_data_type(thread_group &group, remote_function_registry &&registry, std::string &&socketPath, const options_type &options)
+        : m_Group(group)
+        , m_Registry(std::move(registry))
+        , m_SocketPath(std::move(socketPath))
+        , m_Options(options)
+        {}
+
+        static void join(connection_type &connection)
+        {
+            connection.m_Reader.join();
+            connection.m_Writer.join();
+
+            ::close(connection.m_Socket);
+        }
+
+        void accept_connections()
+        {
+            for (;;)
+            {
+                const auto socket = ::accept(m_ListenSocket, nullptr, nullptr);
+
+                if (m_IsStopping.load())
+                {
+                    if (socket >= 0) ::close(socket);
+
+                    return;
+                }
+
+                if (socket < 0)
+                {
+                    if (errno == EINTR || errno == ECONNABORTED) continue;
+
+                    return;
+                }
+
+                auto pConnection = std::make_shared<connection_type>(socket);
+
+                std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+
+                // reap connections whose clients have gone
+                for (auto it = m_Connections.begin(); it != m_Connections.end();)
+                {
+                    if ((*it)->m_IsFinished.load())
+                    {
+                        join(**it);
+
+                        it = m_Connections.erase(it);
+                    }
+                    else ++it;
+                }
+
+                pConnection->m_Reader = std::thread([this, pConnection]() { read_requests(pConnection); });
+                pConnection->m_Writer = std::thread([this, pConnection]() { write_responses(pConnection); });
+
+                m_Connections.push_back(std::move(pConnection));
+            }
+        }
+
+        thread_group::task_type make_task(std::shared_ptr<connection_type> pConnection, record_type &&request)
+        {
+            return [this, pConnection, request = std::move(request)]()
+            {
+                record_type response{request.id, RESPONSE_SUCCEEDED, {}};
+
+                if (const auto pHandler = m_Registry.find(request.tag))
+                {
+                    try
+                    {
+                        response.payload = (*pHandler)(request.payload);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        response = {request.id, RESPONSE_FAILED, e.what()};
+                    }
+                    catch (...)
+                    {
+                        response = {request.id, RESPONSE_FAILED, "unknown exception"};
+                    }
+                }
+                else response = {request.id, RESPONSE_FAILED, "function is not registered with the worker"};
+
+                if (response.payload.size() > remote_executor::MAX_PAYLOAD_SIZE) response = {request.id, RESPONSE_FAILED, "result is larger than the frame size limit"};
+
+                m_CompletedRequestCount.fetch_add(1, std::memory_order_relaxed);
+
+                std::lock_guard<std::mutex> lock(pConnection->m_Mutex);
+
+                pConnection->m_Responses.push_back(std::move(response));
+
+                --pConnection->m_InFlight;
+
+                pConnection->m_Condition.notify_all();
+            };
+        }
+
+        void read_requests(const std::shared_ptr<connection_type> pConnection)
+        {
+            auto &connection = *pConnection;
+
+            std::vector<record_type> requests;
+
+            std::vector<thread_group::task_type> tasks;
+
+            bool is_stopping(false);
+
+            while (!is_stopping && read_frame(connection.m_Socket, requests))
+            {
+                for (auto &request : requests)
+                {
+                    std::unique_lock<std::mutex> lock(connection.m_Mutex);
+
+                    if (connection.m_InFlight >= m_Options.max_in_flight)
+                    {
+                        // the requests held back must be queued before waiting on them to finish
+                        lock.unlock();
+
+                        m_Group.add_tasks(std::move(tasks));
+
+                        tasks.clear();
+
+                        lock.lock();
+
+                        connection.m_Condition.wait(lock, [&]() { return connection.m_InFlight < m_Options.max_in_flight || m_IsStopping.load(); });
+
+                        // woken by the worker stopping rather than by a free slot, so the rest of the frame is dropped
+                        if ((is_stopping = m_IsStopping.load())) break;
+                    }
+
+                    ++connection.m_InFlight;
+
+                    lock.unlock();
+
+                    tasks.push_back(make_task(pConnection, std::move(request)));
+                }
+
+                m_Group.add_tasks(std::move(tasks));
+
+                tasks.clear();
+            }
+
+            std::lock_guard<std::mutex> lock(connection.m_Mutex);
+
+            connection.m_IsReadDone = true;
+
+            connection.m_Condition.notify_all();
+        }
+
+        void write_responses(const std::shared_ptr<connection_type> pConnection)
+        {
+            auto &connection = *pConnection;
+
+            std::vector<record_type> responses;
+
+            bool is_writable = true;
+
+            std::unique_lock<std::mutex> lock(connection.m_Mutex);
+
+            for (;;)
+            {
+                connection.m_Condition.wait(lock, [&]()
+                {
+                    return !connection.m_Responses.empty() || (connection.m_IsReadDone && !connection.m_InFlight);
+                });
+
+                if (connection.m_Responses.empty()) break;
+
+                responses.swap(connection.m_Responses);
+
+                lock.unlock();
+
+                // once the client stops reading, responses are dropped, but requests still running are waited for
+                if (is_writable) is_writable = write_frames(connection.m_Socket, responses.begin(), responses.end());
+
+                if (!is_writable) ::shutdown(connection.m_Socket, SHUT_RD);
+
+                responses.clear();
+
+                lock.lock();
+            }
+
+            connection.m_IsFinished = true;
+        }
+    };
+
+    const std::string &remote_worker::socket_path() const
+    {
+        return m_SharedData->m_SocketPath;
+    }
+
+    size_t remote_worker::completed_request_count() const
+    {
+        return m_SharedData->m_CompletedRequestCount.load(std::memory_order_relaxed);
+    }
+
+    remote_worker::remote_worker(thread_group &group, remote_function_registry registry, std::string socketPath, const options_type options)
+    : m_SharedData(std::make_shared<shared_data_type>(group, std::move(registry), std::move(socketPath), options))
+    {
+        if (!options.max_in_flight) throw std::invalid_argument("jfc::remote_worker: max in flight must be nonzero");
+
+        auto &shared = *m_SharedData;
+
+        const auto address = make_address(shared.m_SocketPath, "jfc::remote_worker");
+
+        shared.m_ListenSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (shared.m_ListenSocket < 0) throw std::system_error(errno, std::generic_category(), "jfc::remote_worker: could not create socket");
+
+        if (::bind(shared.m_ListenSocket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 || ::listen(shared.m_ListenSocket, SOMAXCONN) < 0)
+        {
+            const std::system_error error(errno, std::generic_category(), "jfc::remote_worker: could not listen on " + shared.m_SocketPath);
+
+            ::close(shared.m_ListenSocket);
+
+            throw error;
+        }
+
+        shared.m_Acceptor = std::thread([&shared]() { shared.accept_connections(); });
+    }
+
+    remote_worker::remote_worker(thread_group &group, remote_function_registry registry, std::string socketPath)
+    : remote_worker(group, std::move(registry), std::move(socketPath), options_type())
+    {}
+
+    remote_worker::~remote_worker()
+    {
+        auto &shared = *m_SharedData;
+
+        shared.m_IsStopping = true;
+
+        // wakes the acceptor
+        ::shutdown(shared.m_ListenSocket, SHUT_RDWR);
+
+        shared.m_Acceptor.join();
+
+        ::close(shared.m_ListenSocket);
+
+        ::unlink(shared.m_SocketPath.c_str());
+
+        std::lock_guard<std::mutex> lock(shared.m_ConnectionsMutex);
+
+        for (auto &pConnection : shared.m_Connections)
+        {
+            ::shutdown(pConnection->m_Socket, SHUT_RD);
+
+            {
+                std::lock_guard<std::mutex> connectionLock(pConnection->m_Mutex);
+
+                pConnection->m_Condition.notify_all();
+            }
+
+            shared_data_type::join(*pConnection);
+        }
+    }
+
+    struct remote_executor::shared_data_type
+    {
+        const options_type m_Options;
+
+        int m_Socket = -1;
+
+        std::mutex m_Mutex;
+
+        /// \brief wakes the sender when calls are queued
+        std::condition_variable m_SendCondition;
+
+        /// \brief wakes submitters when results return credit to the window
+        std::condition_variable m_CreditCondition;
+
+        std::vector<record_type> m_Outgoing;
+
+        /// \brief completions of calls awaiting results, by call id
+        std::unordered_map<std::uint64_t, completion_type> m_Pending;
+
+        std::uint64_t m_NextId = 0;
+
+        bool m_IsStopping = false;
+
+        bool m_IsBroken = false;
+
+        std::thread m_Sender;
+
+        std::thread m_Receiver;
+
+        shared_data_type(const options_type &options)
+        : m_Options(options)
+        {}
+
+        /// \brief fails every pending call with reason, and any later submission
+        void break_connection(const std::string &reason)
+        {
+            std::unordered_map<std::uint64_t, completion_type> pending;
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+
+                m_IsBroken = true;
+
+                pending.swap(m_Pending);
+
+                m_Outgoing.clear();
+
+                m_SendCondition.notify_all();
+                m_CreditCondition.notify_all();
+            }
+
+            for (auto &[id, completion] : pending) completion(false, reason);
+        }
+
+        void send_requests()
+        {
+            std::vector<record_type> batch;
+
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            for (;;)
+            {
+                m_SendCondition.wait(lock, [this]() { return !m_Outgoing.empty() || m_IsStopping || m_IsBroken; });
+
+                if (m_Outgoing.empty() || m_IsBroken) return;
+
+                if (m_Outgoing.size() <= m_Options.max_batch_size) batch.swap(m_Outgoing);
+                else
+                {
+                    const auto end = m_Outgoing.begin() + m_Options.max_batch_size;
+
+                    batch.assign(std::make_move_iterator(m_Outgoing.begin()), std::make_move_iterator(end));
+
+                    m_Outgoing.erase(m_Outgoing.begin(), end);
+                }
+
+                lock.unlock();
+
+                const auto is_written = write_frames(m_Socket, batch.begin(), batch.end());
+
+                batch.clear();
+
+                if (!is_written)
+                {
+                    break_connection("connection lost");
+
+                    return;
+                }
+
+                lock.lock();
+            }
+        }
+
+        void receive_responses()
+        {
+            std::vector<record_type> responses;
+
+            while (read_frame(m_Socket, responses))
+            {
+                for (auto &response : responses)
+                {
+                    completion_type completion;
+
+                    {
+                        std::lock_guard<std::mutex> lock(m_Mutex);
+
+                        const auto it = m_Pending.find(response.id);
+
+                        if (it == m_Pending.end()) continue;
+
+                        completion = std::move(it->second);
+
+                        m_Pending.erase(it);
+
+                        m_CreditCondition.notify_one();
+                    }
+
+                    completion(response.tag == RESPONSE_SUCCEEDED, std::move(response.payload));
+                }
+            }
+
+            break_connection("connection lost");
+        }
+    };
+
+    void remote_executor::submit_encoded(const std::uint32_t functionId, std::string argument, completion_type completion)
+    {
+        // checked before taking a slot in the window, since the worker would drop the whole connection on reading it
+        if (argument.size() > MAX_PAYLOAD_SIZE) throw std::invalid_argument("jfc::remote_executor: argument of " + std::to_string(argument.size()) + " bytes is larger than the frame size limit");
+
+        auto &shared = *m_SharedData;
+
+        std::unique_lock<std::mutex> lock(shared.m_Mutex);
+
+        shared.m_CreditCondition.wait(lock, [&shared]() { return shared.m_Pending.size() < shared.m_Options.max_in_flight || shared.m_IsBroken; });
+
+        if (shared.m_IsBroken) throw std::runtime_error("jfc::remote_executor: the connection to the worker has been lost");
+
+        const auto id = shared.m_NextId++;
+
+        shared.m_Pending.emplace(id, std::move(completion));
+
+        shared.m_Outgoing.push_back({id, functionId, std::move(argument)});
+
+        shared.m_SendCondition.notify_one();
+    }
+
+    size_t remote_executor::in_flight_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_SharedData->m_Mutex);
+
+        return m_SharedData->m_Pending.size();
+    }
+
+    remote_executor::remote_executor(const std::string &socketPath, const options_type options)
+    : m_SharedData(std::make_shared<shared_data_type>(options))
+    {
+        if (!options.max_in_flight || !options.max_batch_size) throw std::invalid_argument("jfc::remote_executor: max in flight and max batch size must be nonzero");
+
+        auto &shared = *m_SharedData;
+
+        const auto address = make_address(socketPath, "jfc::remote_executor");
+
+        shared.m_Socket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (shared.m_Socket < 0) throw std::system_error(errno, std::generic_category(), "jfc::remote_executor: could not create socket");
+
+        if (::connect(shared.m_Socket, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            const std::system_error error(errno, std::generic_category(), "jfc::remote_executor: could not connect to " + socketPath);
+
+            ::close(shared.m_Socket);
+
+            throw error;
+        }
+
+        shared.m_Sender = std::thread([&shared]() { shared.send_requests(); });
+        shared.m_Receiver = std::thread([&shared]() { shared.receive_responses(); });
+    }
+
+    remote_executor::remote_executor(const std::string &socketPath)
+    : remote_executor(socketPath, options_type())
+    {}
+
+    remote_executor::~remote_executor()
+    {
+        auto &shared = *m_SharedData;
+
+        {
+            std::lock_guard<std::mutex> lock(shared.m_Mutex);
+
+            shared.m_IsStopping = true;
+
+            shared.m_SendCondition.notify_all();
+        }
+
+        // queued calls are sent before the sender stops
+        shared.m_Sender.join();
+
+        ::shutdown(shared.m_Socket, SHUT_RDWR);
+
+        shared.m_Receiver.join();
+
+        ::close(shared.m_Socket);
+    }
+}
+
+#endif
@@ -0,0 +1,32 @@
+#include <jfc/scratch_arena.h>
+
+namespace jfc
+{
+    /// \brief the arena current on this thread
+    static thread_local scratch_arena *t_pCurrentArena = nullptr;
+
+    scratch_arena::current_scope::current_scope(scratch_arena *const pArena)
+    : m_pPrevious(t_pCurrentArena)
+    {
+        t_pCurrentArena = pArena;
+    }
+
+    scratch_arena::current_scope::~current_scope()
+    {
+        t_pCurrentArena = m_pPrevious;
+    }
+
+    scratch_arena *scratch_arena::current()
+    {
+        return t_pCurrentArena;
+    }
+
+    scratch_arena::scratch_arena(const size_t capacity)
+    : m_Capacity(capacity)
+    {}
+
+    scratch_arena::scratch_arena(void *const pBuffer, const size_t capacity)
+    : m_pData(static_cast<unsigned char *>(pBuffer))
+    , m_Capacity(capacity)
+    {}
+}
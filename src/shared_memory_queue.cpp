@@ -0,0 +1,124 @@
+#include <jfc/shared_memory_queue.h>
+
+#ifdef JFC_SHARED_MEMORY_SUPPORTED
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace jfc
+{
+    /// \brief how long an opener waits for the creator to size the object before deciding it is too small
+    static constexpr std::chrono::seconds OPEN_SIZE_TIMEOUT(1);
+
+    /// \brief longest sleep between an opener's checks of the object's size
+    static constexpr std::chrono::milliseconds OPEN_SIZE_MAX_BACKOFF(10);
+
+    static std::system_error make_system_error(const std::string &what)
+    {
+        return std::system_error(errno, std::generic_category(), "jfc::shared_memory_region: " + what);
+    }
+
+    void shared_memory_region::unlink()
+    {
+        if (!m_Name.empty()) ::shm_unlink(m_Name.c_str());
+
+        m_IsOwner = false;
+    }
+
+    shared_memory_region::shared_memory_region(std::string name, const size_t size, const open_mode mode)
+    : m_Name(std::move(name))
+    , m_Size(size)
+    , m_IsOwner(mode == open_mode::create)
+    {
+        const auto descriptor = ::shm_open(m_Name.c_str(), m_IsOwner ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, S_IRUSR | S_IWUSR);
+
+        if (descriptor < 0) throw make_system_error((m_IsOwner ? "could not create " : "could not open ") + m_Name);
+
+        // the descriptor is not needed once mapped
+        struct descriptor_guard
+        {
+            int m_Descriptor;
+
+            ~descriptor_guard() { ::close(m_Descriptor); }
+        } guard{descriptor};
+
+        if (m_IsOwner)
+        {
+            if (::ftruncate(descriptor, static_cast<off_t>(size)) < 0)
+            {
+                const auto error = make_system_error("could not size " + m_Name);
+
+                ::shm_unlink(m_Name.c_str());
+
+                throw error;
+            }
+        }
+        else
+        {
+            // the creator sizes the object after creating it, so an opener may find it empty until then
+            const auto deadline = std::chrono::steady_clock::now() + OPEN_SIZE_TIMEOUT;
+
+            for (std::chrono::microseconds backoff(50);; backoff = std::min<std::chrono::microseconds>(backoff * 2, OPEN_SIZE_MAX_BACKOFF))
+            {
+                struct stat status;
+
+                if (::fstat(descriptor, &status) < 0) throw make_system_error("could not stat " + m_Name);
+
+                if (static_cast<size_t>(status.st_size) >= size) break;
+
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    errno = EINVAL;
+
+                    throw make_system_error(m_Name + " is smaller than requested");
+                }
+
+                std::this_thread::sleep_for(backoff);
+            }
+        }
+
+        m_pAddress = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+        if (m_pAddress == MAP_FAILED)
+        {
+            const auto error = make_system_error("could not map " + m_Name);
+
+            if (m_IsOwner) ::shm_unlink(m_Name.c_str());
+
+            throw error;
+        }
+    }
+
+    shared_memory_region::~shared_memory_region()
+    {
+        ::munmap(m_pAddress, m_Size);
+
+        if (m_IsOwner) unlink();
+    }
+
+    namespace detail
+    {
+        // the words live in shared mappings, so the futexes are not FUTEX_PRIVATE_FLAG: the kernel keys them on the underlying page, not the address
+        void futex_wait(std::atomic<std::uint32_t> &word, const std::uint32_t expected)
+        {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+        }
+
+        void futex_wake(std::atomic<std::uint32_t> &word, const int count)
+        {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE, count, nullptr, nullptr, 0);
+        }
+    }
+}
+
+#endif
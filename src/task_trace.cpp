@@ -0,0 +1,618 @@
+#include <jfc/task_trace.h>
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace jfc
+{
+    /// \brief first line of a written trace
+    static constexpr const char *TRACE_HEADER = "# jfc task trace 1";
+
+    const task_trace::record_collection_type &task_trace::records() const
+    {
+        return m_Records;
+    }
+
+    std::int64_t task_trace::recorded_makespan() const
+    {
+        if (m_Records.empty()) return 0;
+
+        auto first_submit = std::numeric_limits<std::int64_t>::max();
+        auto last_end = std::numeric_limits<std::int64_t>::min();
+
+        for (const auto &record : m_Records)
+        {
+            first_submit = std::min(first_submit, record.submit_time);
+            last_end = std::max(last_end, record.end_time);
+        }
+
+        return last_end - first_submit;
+    }
+
+    /// \brief the relations between a trace's records, by record index, as modelled by simulate and critical_path
+    struct task_trace::graph_type
+    {
+        static constexpr size_t NO_TASK = std::numeric_limits<size_t>::max();
+
+        /// \brief run time of each task, excluding nested tasks
+        std::vector<std::int64_t> m_Duration;
+
+        /// \brief time into its parent's run at which each task was submitted
+        std::vector<std::int64_t> m_SpawnOffset;
+
+        /// \brief each task's parent, NO_TASK for tasks submitted from outside the group or whose parent is absent from the trace
+        std::vector<size_t> m_Parent;
+
+        std::vector<std::vector<size_t>> m_Children;
+
+        std::vector<std::vector<size_t>> m_Dependencies;
+
+        std::vector<std::vector<size_t>> m_Dependents;
+
+        std::int64_t m_FirstSubmit = std::numeric_limits<std::int64_t>::max();
+
+        /// \brief sum of the run times
+        std::int64_t m_Work = 0;
+
+        graph_type(const record_collection_type &records)
+        : m_Duration(records.size())
+        , m_SpawnOffset(records.size())
+        , m_Parent(records.size(), NO_TASK)
+        , m_Children(records.size())
+        , m_Dependencies(records.size())
+        , m_Dependents(records.size())
+        {
+            const auto count = records.size();
+
+            std::unordered_map<id_type, size_t> index_of;
+
+            for (size_t i(0); i < count; ++i) index_of[records[i].id] = i;
+
+            const auto find = [&index_of](const id_type id)
+            {
+                const auto it = index_of.find(id);
+
+                return it != index_of.end() ? it->second : NO_TASK;
+            };
+
+            for (size_t i(0); i < count; ++i)
+            {
+                const auto &record = records[i];
+
+                m_Duration[i] = std::max<std::int64_t>(record.end_time - record.start_time - record.nested_time, 0);
+
+                m_Work += m_Duration[i];
+
+                m_FirstSubmit = std::min(m_FirstSubmit, record.submit_time);
+            }
+
+            for (size_t i(0); i < count; ++i)
+            {
+                const auto &record = records[i];
+
+                const auto parent = find(record.parent);
+
+                if (parent != NO_TASK && parent != i)
+                {
+                    m_Parent[i] = parent;
+
+                    m_SpawnOffset[i] = std::clamp<std::int64_t>(record.submit_time - records[parent].start_time, 0, m_Duration[parent]);
+
+                    m_Children[parent].push_back(i);
+                }
+
+                for (const auto dependency : record.dependencies)
+                {
+                    const auto predecessor = find(dependency);
+
+                    if (predecessor == NO_TASK || predecessor == i) continue;
+
+                    m_Dependencies[i].push_back(predecessor);
+
+                    m_Dependents[predecessor].push_back(i);
+                }
+            }
+        }
+    };
+
+    task_trace::simulation_result_type task_trace::simulate(const size_t workerCount, const scheduling_policy policy) const
+    {
+        if (!workerCount) throw std::invalid_argument("jfc::task_trace: cannot simulate zero workers");
+
+        simulation_result_type result{workerCount, policy, 0, 0};
+
+        if (m_Records.empty()) return result;
+
+        const auto count = m_Records.size();
+
+        const graph_type graph(m_Records);
+
+        const auto &duration = graph.m_Duration;
+
+        // tasks submitted from outside the group are released at their recorded submission, others relative to their parent's simulated start
+        std::vector<std::int64_t> release_time(count);
+
+        // unreleased parents, incomplete dependencies
+        std::vector<size_t> unmet_parents(count), unmet_dependencies(count);
+
+        // true once a task has run for its duration but is still waiting for its dependencies
+        std::vector<bool> is_waiting(count, false);
+
+        for (size_t i(0); i < count; ++i)
+        {
+            const bool has_parent = graph.m_Parent[i] != graph_type::NO_TASK;
+
+            release_time[i] = has_parent ? std::numeric_limits<std::int64_t>::min() : m_Records[i].submit_time;
+
+            unmet_parents[i] = has_parent;
+
+            unmet_dependencies[i] = graph.m_Dependencies[i].size();
+        }
+
+        // a task reaching the end of its run time, or being released. Ties are broken by trace order so that simulations are deterministic
+        struct event_type
+        {
+            std::int64_t m_Time;
+
+            bool m_IsRunEnd;
+
+            size_t m_Task;
+
+            bool operator>(const event_type &b) const
+            {
+                if (m_Time != b.m_Time) return m_Time > b.m_Time;
+
+                if (m_IsRunEnd != b.m_IsRunEnd) return b.m_IsRunEnd;
+
+                return m_Task > b.m_Task;
+            }
+        };
+
+        std::priority_queue<event_type, std::vector<event_type>, std::greater<event_type>> events;
+
+        for (size_t i(0); i < count; ++i) if (!unmet_parents[i]) events.push({release_time[i], false, i});
+
+        // ready tasks, keyed so that the highest key is picked first
+        std::priority_queue<std::pair<std::int64_t, size_t>> ready;
+
+        std::int64_t release_sequence(0);
+
+        const auto ready_key = [&](const size_t task) -> std::int64_t
+        {
+            ++release_sequence;
+
+            switch (policy)
+            {
+                case scheduling_policy::lifo: return release_sequence;
+                case scheduling_policy::longest_first: return duration[task];
+                case scheduling_policy::fifo: break;
+            }
+
+            return -release_sequence;
+        };
+
+        size_t idle_workers(workerCount), completed(0);
+
+        std::int64_t last_end(graph.m_FirstSubmit);
+
+        std::vector<size_t> completions;
+
+        const auto complete = [&](const size_t task, const std::int64_t time)
+        {
+            completions.push_back(task);
+
+            while (!completions.empty())
+            {
+                const auto finished = completions.back();
+
+                completions.pop_back();
+
+                ++completed;
+
+                last_end = std::max(last_end, time);
+
+                for (const auto dependent : graph.m_Dependents[finished])
+                {
+                    if (!--unmet_dependencies[dependent] && is_waiting[dependent]) completions.push_back(dependent);
+                }
+            }
+        };
+
+        while (!events.empty())
+        {
+            const auto now = events.top().m_Time;
+
+            while (!events.empty() && events.top().m_Time == now)
+            {
+                const auto event = events.top();
+
+                events.pop();
+
+                if (event.m_IsRunEnd)
+                {
+                    ++idle_workers;
+
+                    if (unmet_dependencies[event.m_Task]) is_waiting[event.m_Task] = true;
+                    else complete(event.m_Task, now);
+                }
+                else ready.push({ready_key(event.m_Task), event.m_Task});
+            }
+
+            while (idle_workers && !ready.empty())
+            {
+                const auto task = ready.top().second;
+
+                ready.pop();
+
+                --idle_workers;
+
+                events.push({now + duration[task], true, task});
+
+                for (const auto child : graph.m_Children[task])
+                {
+                    release_time[child] = std::max(release_time[child], now + graph.m_SpawnOffset[child]);
+
+                    if (!--unmet_parents[child]) events.push({release_time[child], false, child});
+                }
+            }
+        }
+
+        if (completed != count) throw std::runtime_error("jfc::task_trace: trace contains a dependency cycle");
+
+        result.makespan = last_end - graph.m_FirstSubmit;
+
+        if (result.makespan > 0) result.utilisation = static_cast<double>(graph.m_Work) / (static_cast<double>(result.makespan) * workerCount);
+
+        return result;
+    }
+
+    task_trace::critical_path_type task_trace::critical_path() const
+    {
+        critical_path_type result{0, 0, 0, {}};
+
+        if (m_Records.empty()) return result;
+
+        const auto count = m_Records.size();
+
+        const graph_type graph(m_Records);
+
+        constexpr auto NO_TASK = graph_type::NO_TASK;
+
+        // earliest start: the recorded submission for tasks submitted from outside the group, otherwise the parent's earliest start plus the spawn offset
+        std::vector<std::int64_t> start(count);
+
+        std::vector<bool> is_started(count, false);
+
+        std::vector<size_t> ancestors;
+
+        for (size_t i(0); i < count; ++i)
+        {
+            for (auto task = i; !is_started[task]; task = graph.m_Parent[task])
+            {
+                ancestors.push_back(task);
+
+                if (graph.m_Parent[task] == NO_TASK) break;
+
+                if (ancestors.size() > count) throw std::runtime_error("jfc::task_trace: trace contains a spawn cycle");
+            }
+
+            for (; !ancestors.empty(); ancestors.pop_back())
+            {
+                const auto task = ancestors.back();
+
+                const auto parent = graph.m_Parent[task];
+
+                start[task] = parent == NO_TASK ? m_Records[task].submit_time : start[parent] + graph.m_SpawnOffset[task];
+
+                is_started[task] = true;
+            }
+        }
+
+        // earliest finish: the end of the task's own run, or of its last dependency. Tasks are visited in dependency order
+        std::vector<std::int64_t> finish(count);
+
+        // the dependency that determined each task's finish, if any
+        std::vector<size_t> critical_dependency(count, NO_TASK);
+
+        std::vector<size_t> remaining(count), ready;
+
+        for (size_t i(0); i < count; ++i) if (!(remaining[i] = graph.m_Dependencies[i].size())) ready.push_back(i);
+
+        size_t visited(0), last(NO_TASK);
+
+        while (!ready.empty())
+        {
+            const auto task = ready.back();
+
+            ready.pop_back();
+
+            ++visited;
+
+            finish[task] = start[task] + graph.m_Duration[task];
+
+            for (const auto dependency : graph.m_Dependencies[task]) if (finish[dependency] > finish[task])
+            {
+                finish[task] = finish[dependency];
+
+                critical_dependency[task] = dependency;
+            }
+
+            if (last == NO_TASK || finish[task] > finish[last] || (finish[task] == finish[last] && task > last)) last = task;
+
+            for (const auto dependent : graph.m_Dependents[task]) if (!--remaining[dependent]) ready.push_back(dependent);
+        }
+
+        if (visited != count) throw std::runtime_error("jfc::task_trace: trace contains a dependency cycle");
+
+        // walks back from the last task to finish: through the dependency that held it up, else through the parent that spawned it
+        for (auto task = last; task != NO_TASK;)
+        {
+            result.tasks.push_back(m_Records[task].id);
+
+            task = critical_dependency[task] != NO_TASK ? critical_dependency[task] : graph.m_Parent[task];
+        }
+
+        std::reverse(result.tasks.begin(), result.tasks.end());
+
+        result.work = graph.m_Work;
+
+        result.span = finish[last] - graph.m_FirstSubmit;
+
+        result.parallelism = result.span > 0 ? static_cast<double>(result.work) / result.span : 0;
+
+        return result;
+    }
+
+    void task_trace::print_report(std::ostream &output, const size_t topTaskCount) const
+    {
+        const auto path = critical_path();
+
+        std::set<std::int64_t> workers;
+
+        std::int64_t queued_time(0);
+
+        for (const auto &record : m_Records)
+        {
+            if (record.worker >= 0) workers.insert(record.worker);
+
+            queued_time += record.start_time - record.submit_time;
+        }
+
+        const auto microseconds = [](const double nanoseconds) { return nanoseconds / 1000; };
+
+        const auto flags = output.flags();
+        const auto precision = output.precision();
+
+        output << std::fixed << std::setprecision(2)
+            << "tasks:               " << m_Records.size() << '\n'
+            << "workers seen:        " << workers.size() << '\n'
+            << "work:                " << microseconds(path.work) << " us\n"
+            << "span:                " << microseconds(path.span) << " us\n"
+            << "parallelism:         " << path.parallelism << '\n'
+            << "recorded makespan:   " << microseconds(recorded_makespan()) << " us\n";
+
+        if (!workers.empty())
+        {
+            output << "lower bound:         " << microseconds(std::max<double>(path.span, static_cast<double>(path.work) / workers.size()))
+                << " us (the greater of span and work / workers seen)\n";
+        }
+
+        if (!m_Records.empty()) output << "mean time queued:    " << microseconds(static_cast<double>(queued_time) / m_Records.size()) << " us\n";
+
+        output << "critical path:       " << path.tasks.size() << " tasks\n";
+
+        if (!path.tasks.empty() && topTaskCount)
+        {
+            std::unordered_map<id_type, const record_type *> record_of;
+
+            for (const auto &record : m_Records) record_of[record.id] = &record;
+
+            std::vector<const record_type *> critical;
+
+            for (const auto id : path.tasks) critical.push_back(record_of[id]);
+
+            const auto run_time = [](const record_type *pRecord) { return pRecord->end_time - pRecord->start_time - pRecord->nested_time; };
+
+            std::stable_sort(critical.begin(), critical.end(), [&run_time](const record_type *a, const record_type *b)
+            {
+                return run_time(a) > run_time(b);
+            });
+
+            if (critical.size() > topTaskCount) critical.resize(topTaskCount);
+
+            output << "longest critical tasks:\n"
+                << std::setw(12) << "id" << std::setw(12) << "parent" << std::setw(8) << "worker" << std::setw(16) << "run time (us)" << '\n';
+
+            for (const auto pRecord : critical)
+            {
+                output << std::setw(12) << pRecord->id << std::setw(12) << pRecord->parent << std::setw(8) << pRecord->worker
+                    << std::setw(16) << microseconds(run_time(pRecord)) << '\n';
+            }
+        }
+
+        output.flags(flags);
+        output.precision(precision);
+    }
+
+    void task_trace::write(std::ostream &output) const
+    {
+        output << TRACE_HEADER << '\n';
+        output << "# id parent worker submit start end nested dependencies...\n";
+
+        for (const auto &record : m_Records)
+        {
+            output << record.id << ' ' << record.parent << ' ' << record.worker << ' '
+                << record.submit_time << ' ' << record.start_time << ' ' << record.end_time << ' ' << record.nested_time;
+
+            for (const auto dependency : record.dependencies) output << ' ' << dependency;
+
+            output << '\n';
+        }
+    }
+
+    task_trace task_trace::read(std::istream &input)
+    {
+        std::string line;
+
+        if (!std::getline(input, line) || line != TRACE_HEADER) throw std::runtime_error("jfc::task_trace: input is not a task trace");
+
+        record_collection_type records;
+
+        while (std::getline(input, line))
+        {
+            if (line.empty() || line.front() == '#') continue;
+
+            std::istringstream fields(line);
+
+            record_type record{};
+
+            if (!(fields >> record.id >> record.parent >> record.worker >> record.submit_time >> record.start_time >> record.end_time >> record.nested_time))
+            {
+                throw std::runtime_error("jfc::task_trace: malformed record: " + line);
+            }
+
+            for (id_type dependency; fields >> dependency;) record.dependencies.push_back(dependency);
+
+            records.push_back(std::move(record));
+        }
+
+        return task_trace(std::move(records));
+    }
+
+    task_trace::task_trace(record_collection_type records)
+    : m_Records(std::move(records))
+    {}
+
+    /// \brief a traced task running on the calling thread
+    struct running_task_type
+    {
+        const task_trace_recorder *m_pRecorder;
+
+        task_trace_recorder::id_type m_ID;
+
+        std::int64_t m_StartTime;
+
+        /// \brief time spent in traced tasks of the same recorder nested inside this one
+        std::int64_t m_NestedTime;
+    };
+
+    /// \brief traced tasks running on the calling thread, innermost last. Tasks nest when a task runs others, e.g. via try_get_task
+    static thread_local std::vector<running_task_type> t_RunningTasks;
+
+    std::int64_t task_trace_recorder::now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - m_StartTime).count();
+    }
+
+    task_trace_recorder::id_type task_trace_recorder::on_submit()
+    {
+        const auto parent = current_task_id();
+
+        const auto submit_time = now();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const id_type id = m_Records.size() + 1;
+
+        m_Records.push_back({id, parent.value_or(0), -1, submit_time, 0, 0, 0, {}});
+
+        return id;
+    }
+
+    void task_trace_recorder::on_start(const id_type id, const std::int64_t worker)
+    {
+        const auto start_time = now();
+
+        t_RunningTasks.push_back({this, id, start_time, 0});
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto &record = m_Records[id - 1];
+
+        record.worker = worker;
+        record.start_time = start_time;
+    }
+
+    void task_trace_recorder::on_finish(const id_type id)
+    {
+        const auto end_time = now();
+
+        std::int64_t nested_time(0);
+
+        // the finishing task is innermost unless a nested task threw past its own on_finish
+        while (!t_RunningTasks.empty())
+        {
+            const auto running = t_RunningTasks.back();
+
+            t_RunningTasks.pop_back();
+
+            if (running.m_pRecorder == this && running.m_ID == id)
+            {
+                nested_time = running.m_NestedTime;
+
+                for (auto it = t_RunningTasks.rbegin(); it != t_RunningTasks.rend(); ++it) if (it->m_pRecorder == this)
+                {
+                    it->m_NestedTime += end_time - running.m_StartTime;
+
+                    break;
+                }
+
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        auto &record = m_Records[id - 1];
+
+        record.end_time = end_time;
+        record.nested_time = nested_time;
+
+        m_Completed.push_back(id);
+    }
+
+    void task_trace_recorder::record_dependency(const id_type predecessor)
+    {
+        const auto current = current_task_id();
+
+        if (!current) return;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_Records[*current - 1].dependencies.push_back(predecessor);
+    }
+
+    std::optional<task_trace_recorder::id_type> task_trace_recorder::current_task_id() const
+    {
+        for (auto it = t_RunningTasks.rbegin(); it != t_RunningTasks.rend(); ++it) if (it->m_pRecorder == this) return it->m_ID;
+
+        return {};
+    }
+
+    task_trace task_trace_recorder::trace() const
+    {
+        task_trace::record_collection_type records;
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        records.reserve(m_Completed.size());
+
+        for (const auto id : m_Completed) records.push_back(m_Records[id - 1]);
+
+        return task_trace(std::move(records));
+    }
+
+    task_trace_recorder::task_trace_recorder()
+    : m_StartTime(clock_type::now())
+    {}
+}
@@ -0,0 +1,135 @@
+#include <jfc/thread_count_calibration.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace jfc
+{
+    /// \brief a line of the cache file: key, hardware_concurrency at the time of measurement, best thread count
+    struct cache_entry_type
+    {
+        std::string m_Key;
+
+        size_t m_HardwareConcurrency;
+
+        size_t m_ThreadCount;
+    };
+
+    static std::vector<cache_entry_type> read_cache(const std::string &path)
+    {
+        std::vector<cache_entry_type> entries;
+
+        std::ifstream file(path);
+
+        // lines that do not parse are dropped, so a damaged cache heals on the next write
+        for (std::string line; std::getline(file, line);)
+        {
+            std::istringstream fields(line);
+
+            cache_entry_type entry;
+
+            if (fields >> entry.m_Key >> entry.m_HardwareConcurrency >> entry.m_ThreadCount && entry.m_ThreadCount) entries.push_back(std::move(entry));
+        }
+
+        return entries;
+    }
+
+    static void write_cache(const std::string &path, const std::vector<cache_entry_type> &entries)
+    {
+        std::ofstream file(path, std::ios::trunc);
+
+        for (const auto &entry : entries) file << entry.m_Key << ' ' << entry.m_HardwareConcurrency << ' ' << entry.m_ThreadCount << '\n';
+
+        if (!file) throw std::runtime_error("jfc::calibrate_thread_count: could not write cache file " + path);
+    }
+
+    static std::vector<size_t> default_thread_counts()
+    {
+        const size_t hardware_concurrency = std::max(1u, std::thread::hardware_concurrency());
+
+        std::vector<size_t> counts;
+
+        for (size_t count(1); count < hardware_concurrency; count *= 2) counts.push_back(count);
+
+        if (hardware_concurrency > 1) counts.push_back(hardware_concurrency - 1);
+
+        counts.push_back(hardware_concurrency);
+
+        return counts;
+    }
+
+    size_t calibrate_thread_count(const calibration_workload_type &workload, const calibration_options_type &options)
+    {
+        if (!options.repetitions) throw std::invalid_argument("jfc::calibrate_thread_count: repetitions must be nonzero");
+
+        if (options.tolerance < 0) throw std::invalid_argument("jfc::calibrate_thread_count: tolerance must not be negative");
+
+        if (options.cache_key.empty() || std::any_of(options.cache_key.begin(), options.cache_key.end(), [](const char c) { return std::isspace(static_cast<unsigned char>(c)); }))
+        {
+            throw std::invalid_argument("jfc::calibrate_thread_count: cache key must be nonempty and contain no whitespace");
+        }
+
+        const size_t hardware_concurrency = std::thread::hardware_concurrency();
+
+        std::vector<cache_entry_type> cache;
+
+        if (!options.cache_path.empty())
+        {
+            cache = read_cache(options.cache_path);
+
+            for (const auto &entry : cache) if (entry.m_Key == options.cache_key && entry.m_HardwareConcurrency == hardware_concurrency) return entry.m_ThreadCount;
+        }
+
+        auto counts = options.thread_counts.empty() ? default_thread_counts() : options.thread_counts;
+
+        std::sort(counts.begin(), counts.end());
+
+        counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+
+        std::vector<double> seconds(counts.size(), std::numeric_limits<double>::max());
+
+        for (size_t i(0); i < counts.size(); ++i)
+        {
+            thread_group group(counts[i]);
+
+            workload(group);
+
+            for (size_t repetition(0); repetition < options.repetitions; ++repetition)
+            {
+                const auto start_time = std::chrono::steady_clock::now();
+
+                workload(group);
+
+                seconds[i] = std::min(seconds[i], std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count());
+            }
+        }
+
+        const auto fastest = *std::min_element(seconds.begin(), seconds.end());
+
+        size_t best(counts.back());
+
+        for (size_t i(0); i < counts.size(); ++i) if (seconds[i] <= fastest * (1 + options.tolerance))
+        {
+            best = counts[i];
+
+            break;
+        }
+
+        if (!options.cache_path.empty())
+        {
+            cache.erase(std::remove_if(cache.begin(), cache.end(), [&options](const cache_entry_type &entry) { return entry.m_Key == options.cache_key; }), cache.end());
+
+            cache.push_back({options.cache_key, hardware_concurrency, best});
+
+            write_cache(options.cache_path, cache);
+        }
+
+        return best;
+    }
+}
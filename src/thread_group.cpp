@@ -1,51 +1,1671 @@
 #include <jfc/thread_group.h>
+#include <jfc/huge_page_allocator.h>
+#include <jfc/scratch_arena.h>
+#include <jfc/task_trace.h>
 
 #include <moody/concurrentqueue.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <future>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <thread>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <climits>
+#include <pthread.h>
+#include <unistd.h>
+#define JFC_THREAD_GROUP_USES_PTHREADS
+#endif
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
 namespace jfc
 {
+    /// \brief worker time credited to a tenant of weight 1 each time the round robin visits it
+    static constexpr std::int64_t TENANT_QUANTUM_NANOSECONDS = 200000;
+
+    /// \brief number of consecutive failed attempts to find work before a worker parks
+    static constexpr size_t PARK_SPIN_COUNT = 64;
+
+    /// \brief under two choices placement, an idle worker looks in the other workers' queues once in this many failed attempts to find work
+    static constexpr size_t NEIGHBOUR_SCAN_INTERVAL = 8;
+
+    /// \brief returns a pseudo random number less than bound, from a generator per thread
+    static size_t random_index(const size_t bound)
+    {
+        // xorshift64, seeded apart per thread by the address of its state
+        thread_local std::uint64_t state = reinterpret_cast<std::uintptr_t>(&state) | 1;
+
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        return static_cast<size_t>(state % bound);
+    }
+
+    /// \brief how long an external worker may stay parked before polling its stop condition
+    static constexpr std::chrono::milliseconds EXTERNAL_WORKER_POLL_INTERVAL(1);
+
+    /// \brief size of each worker's scratch arena
+    static constexpr size_t SCRATCH_ARENA_SIZE = 256 * 1024;
+
+    /// \brief the arena the queue allocations of the calling thread are drawn from, nullptr for the heap, see queue_memory_scope
+    static thread_local huge_page_arena *t_pQueueMemory = nullptr;
+
+    /// \brief makes the queue allocations of the calling thread draw from an arena for the lifetime of the scope, restoring the previous one after
+    class queue_memory_scope final
+    {
+            huge_page_arena *m_pPrevious;
+
+        public:
+            explicit queue_memory_scope(huge_page_arena *const pArena)
+            : m_pPrevious(t_pQueueMemory)
+            {
+                t_pQueueMemory = pArena;
+            }
+
+            queue_memory_scope(const queue_memory_scope &) = delete;
+            queue_memory_scope &operator=(const queue_memory_scope &) = delete;
+
+            ~queue_memory_scope()
+            {
+                t_pQueueMemory = m_pPrevious;
+            }
+    };
+
+    /// \brief the queues allocate through static functions, so the group's arena is passed in by queue_memory_scope around each call that may allocate
+    struct queue_traits : moodycamel::ConcurrentQueueDefaultTraits
+    {
+        /// \brief prefixes each allocation, recording the arena it came from so that free needs no scope
+        static constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+        static void *malloc(const size_t size)
+        {
+            auto pArena = t_pQueueMemory;
+
+            void *p = pArena ? pArena->try_allocate(size + HEADER_SIZE, HEADER_SIZE) : nullptr;
+
+            // an arena that cannot grow falls back to the heap
+            if (!p)
+            {
+                pArena = nullptr;
+
+                if (!(p = std::malloc(size + HEADER_SIZE))) return nullptr;
+            }
+
+            *static_cast<huge_page_arena **>(p) = pArena;
+
+            return static_cast<unsigned char *>(p) + HEADER_SIZE;
+        }
+
+        static void free(void *const p)
+        {
+            if (!p) return;
+
+            const auto base = static_cast<unsigned char *>(p) - HEADER_SIZE;
+
+            // arena memory is never reused, only reclaimed with the arena, which the group destroys after its queues
+            if (!*reinterpret_cast<huge_page_arena **>(base)) std::free(base);
+        }
+    };
+
     struct thread_group::shared_data_type
     {
-        using task_collection_type = moodycamel::ConcurrentQueue<task_type>;
+        using task_collection_type = moodycamel::ConcurrentQueue<task_type, queue_traits>;
+
+        /// \brief a tenant's sub queue and its deficit round robin state
+        struct tenant_type
+        {
+            /// \brief tasks submitted by this tenant
+            task_collection_type m_Tasks;
+
+            /// \brief share of worker time relative to other tenants
+            std::int64_t m_Weight;
+
+            /// \brief worker time (ns) the tenant may still consume this round. Charged outside the lock after each task, so it is atomic
+            std::atomic<std::int64_t> m_Deficit;
+
+            tenant_type(std::int64_t weight)
+            : m_Weight(weight)
+            , m_Deficit(0)
+            {}
+        };
+
+        /// \brief a registered task source: fills task with its next chunk, returns false once exhausted
+        using task_source_type = std::function<bool(task_type &)>;
+
+        /// \brief a task that is dropped if not started by its deadline
+        struct deadline_task_type
+        {
+            deadline_type m_Deadline;
+
+            /// \brief submission order, keeps tasks sharing a deadline fifo
+            std::uint64_t m_Sequence;
+
+            task_type m_Task;
+
+            /// \brief heap ordering: the top of the heap is the earliest deadline
+            bool operator<(const deadline_task_type &b) const
+            {
+                return m_Deadline != b.m_Deadline
+                    ? m_Deadline > b.m_Deadline
+                    : m_Sequence > b.m_Sequence;
+            }
+        };
+
+        /// \brief per worker state, for the group's threads and for attached external threads
+        struct worker_data_type
+        {
+            /// \brief the group the worker belongs to
+            const shared_data_type *m_pGroup;
+
+            size_t m_Index;
+
+            bool m_IsExternal;
+
+            /// \brief true while an external thread occupies the slot
+            bool m_IsAttached = true;
+
+            std::atomic<size_t> m_TasksExecuted = 0;
+
+            std::atomic<size_t> m_TimesParked = 0;
+
+            /// \brief functors addressed to this worker alone, checked before any other work
+            task_collection_type m_Mailbox;
+
+            /// \brief temporaries of the task being run, reset after each task
+            scratch_arena m_ScratchArena;
+
+            /// \brief sequence number of the next barrier broadcast the worker is to run. Touched only by the worker's thread
+            std::uint64_t m_NextBarrier = 0;
+
+            worker_data_type(const shared_data_type *pGroup, const size_t index, const bool isExternal, void *const pScratchBuffer)
+            : m_pGroup(pGroup)
+            , m_Index(index)
+            , m_IsExternal(isExternal)
+            , m_ScratchArena(pScratchBuffer
+                ? scratch_arena(pScratchBuffer, SCRATCH_ARENA_SIZE)
+                : scratch_arena(SCRATCH_ARENA_SIZE))
+            {}
+        };
+
+        /// \brief backs the queues and scratch arenas when the group uses huge pages, see memory_attributes_type. Declared first so that it is destroyed last
+        std::unique_ptr<huge_page_arena> m_pHugePages;
+
+        /// \brief tasks are placed here and consumed by threads in the group.
+        task_collection_type m_Tasks;
+
+        /// \brief the queues allocate as they are constructed, so the arena is created, and made current, before the shared data
+        static std::shared_ptr<shared_data_type> make(const memory_attributes_type &memory)
+        {
+            auto pHugePages = memory.huge_pages ? std::make_unique<huge_page_arena>() : nullptr;
+
+            const queue_memory_scope scope(pHugePages.get());
+
+            return std::make_shared<shared_data_type>(std::move(pHugePages));
+        }
+
+        explicit shared_data_type(std::unique_ptr<huge_page_arena> pHugePages)
+        : m_pHugePages(std::move(pHugePages))
+        {}
+
+        /// \brief makes the group's arena, if any, current for queue allocations, see queue_memory_scope. Wrapped around every call that may grow or create a queue
+        queue_memory_scope memory_scope() const
+        {
+            return queue_memory_scope(m_pHugePages.get());
+        }
+
+        /// \brief returns the storage of a worker's scratch arena: drawn from the group's huge page arena if it has one, otherwise nullptr to let the scratch arena allocate its own
+        void *allocate_scratch_buffer()
+        {
+            return m_pHugePages ? m_pHugePages->try_allocate(SCRATCH_ARENA_SIZE) : nullptr;
+        }
+
+        /// \brief a queue per thread of the group, used by two choices placement. Sized on construction, before the threads start
+        std::unique_ptr<task_collection_type[]> m_LocalTasks;
+
+        size_t m_LocalTaskQueueCount = 0;
+
+        std::atomic<task_placement_mode> m_TaskPlacement = task_placement_mode::shared_queue;
+
+        /// \brief set the first time two choices placement is selected and never cleared, lets workers skip the local queues of a group that has never used them
+        std::atomic<bool> m_LocalTasksInUse = false;
+
+        /// \brief exit flag for the worker's loops. When the group falls out of scope (ignoring moves), the threads are told to exit.
+        std::atomic<bool> m_GroupIsDestroyed = false;
+
+        /// \brief guards tenant registration and the round robin state
+        std::mutex m_TenantMutex;
+
+        /// \brief registered tenants. unique_ptr so tenants stay put while the collection grows
+        std::vector<std::unique_ptr<tenant_type>> m_Tenants;
+
+        /// \brief index of the tenant currently being served
+        size_t m_TenantCursor = 0;
+
+        /// \brief copy of m_Tenants.size(), lets workers skip the tenant lock when the group is not in multi-tenant mode
+        std::atomic<size_t> m_TenantCount = 0;
+
+        std::atomic<tenant_charge_mode> m_TenantCharging = tenant_charge_mode::elapsed_time;
+
+        /// \brief guards the deadline heap, sequence and handler
+        std::mutex m_DeadlineMutex;
+
+        /// \brief min heap of deadline tasks
+        std::vector<deadline_task_type> m_DeadlineTasks;
+
+        /// \brief next deadline task sequence number
+        std::uint64_t m_DeadlineSequence = 0;
+
+        /// \brief copy of m_DeadlineTasks.size(), lets workers skip the deadline lock when there are no deadline tasks
+        std::atomic<size_t> m_DeadlineTaskCount = 0;
+
+        /// \brief number of deadline tasks dropped for missing their deadline
+        std::atomic<size_t> m_DroppedTaskCount = 0;
+
+        deadline_missed_handler_type m_DeadlineMissedHandler;
+
+        /// \brief guards the source collection and cursor
+        std::mutex m_SourceMutex;
+
+        /// \brief registered task sources, pulled from in turn
+        std::vector<std::shared_ptr<task_source_type>> m_Sources;
+
+        /// \brief index of the source to pull from next
+        size_t m_SourceCursor = 0;
+
+        /// \brief copy of m_Sources.size(), lets workers skip the source lock when there are no sources
+        std::atomic<size_t> m_SourceCount = 0;
+
+        /// \brief guards the worker slot collection
+        mutable std::mutex m_WorkerMutex;
+
+        /// \brief worker slots. A deque so that slots stay put while external workers attach
+        std::deque<worker_data_type> m_Workers;
+
+        /// \brief guards parking, paired with m_ParkCondition
+        std::mutex m_ParkMutex;
+
+        std::condition_variable m_ParkCondition;
+
+        /// \brief number of workers parked or about to park, lets producers skip notification when every worker is busy
+        std::atomic<size_t> m_ParkedCount = 0;
+
+        /// \brief incremented every time work is added. A parked worker sleeps until this changes from the value it read before it last looked for work
+        std::atomic<std::uint64_t> m_WorkEpoch = 0;
+
+        /// \brief the group's threads with an index at or above this are surplus: they serve only their mailbox, see set_active_worker_count
+        std::atomic<size_t> m_ActiveWorkerCount = 0;
+
+        /// \brief surplus workers wait here rather than on m_ParkCondition, so that a notify_one meant for an active worker cannot be absorbed by a surplus one. Paired with m_ParkMutex
+        std::condition_variable m_SurplusCondition;
+
+        /// \brief true between pause and resume
+        std::atomic<bool> m_IsPaused = false;
+
+        std::atomic<inline_execution_mode> m_InlineExecution = inline_execution_mode::never;
+
+        /// \brief true if tasks added now are to be run by the submitting thread, see set_inline_execution
+        bool should_run_inline() const
+        {
+            switch (m_InlineExecution.load(std::memory_order_relaxed))
+            {
+                case inline_execution_mode::always: return true;
+                case inline_execution_mode::when_no_workers: return !m_ActiveWorkerCount.load(std::memory_order_relaxed);
+                default: return false;
+            }
+        }
+
+        /// \brief runs tasks in order on the calling thread, in place of queueing them
+        void run_inline(std::vector<task_type> &tasks)
+        {
+            trace_task(tasks);
+
+            for (auto &task : tasks) task();
+        }
+        /// \overload
+        void run_inline(task_type &task)
+        {
+            trace_task(task);
+
+            task();
+        }
+
+        /// \brief runs deadline tasks in order on the calling thread, dropping those whose deadline has passed by the time they would start
+        void run_inline(std::vector<task_type> &tasks, const deadline_type deadline)
+        {
+            for (auto &task : tasks)
+            {
+                if (clock_type::now() <= deadline)
+                {
+                    run_inline(task);
+
+                    continue;
+                }
+
+                m_DroppedTaskCount.fetch_add(1, std::memory_order_relaxed);
+
+                deadline_missed_handler_type handler;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_DeadlineMutex);
+
+                    handler = m_DeadlineMissedHandler;
+                }
+
+                if (handler) handler(deadline);
+            }
+        }
+
+        /// \brief paused workers wait here, woken only by resume and destruction, so that work and mail added during a pause cost them nothing. Paired with m_ParkMutex
+        std::condition_variable m_PauseCondition;
+
+        /// \brief a barrier broadcast not yet passed by every thread
+        struct barrier_type
+        {
+            task_type m_Functor;
+
+            /// \brief threads yet to run the functor, guarded by m_BarrierMutex
+            size_t m_Remaining;
+        };
+
+        /// \brief guards the barriers and their counts, paired with m_BarrierCondition
+        std::mutex m_BarrierMutex;
+
+        std::condition_variable m_BarrierCondition;
+
+        /// \brief barriers by sequence number. A mailbox is FIFO only per submitting thread, so two threads' barriers may be taken in different orders by different workers.
+        /// a mailbox task therefore only says that a barrier is due; each worker runs the barriers themselves in sequence order
+        std::map<std::uint64_t, std::shared_ptr<barrier_type>> m_Barriers;
+
+        std::uint64_t m_NextBarrierSequence = 0;
+
+        /// \brief runs the calling worker's next barrier functor, then waits until every thread has run it
+        void run_next_barrier()
+        {
+            auto &worker = *t_pCurrentWorker;
+
+            const auto sequence = worker.m_NextBarrier++;
+
+            std::unique_lock<std::mutex> lock(m_BarrierMutex);
+
+            // held rather than looked up again, since the last thread to arrive erases it
+            const auto pBarrier = m_Barriers.at(sequence);
+
+            lock.unlock();
+
+            pBarrier->m_Functor();
+
+            lock.lock();
+
+            if (!--pBarrier->m_Remaining)
+            {
+                m_Barriers.erase(sequence);
+
+                lock.unlock();
+
+                m_BarrierCondition.notify_all();
+            }
+            else m_BarrierCondition.wait(lock, [&pBarrier]() { return !pBarrier->m_Remaining; });
+        }
+
+        /// \brief guards the trace recorder
+        std::mutex m_TraceMutex;
+
+        std::shared_ptr<task_trace_recorder> m_TraceRecorder;
+
+        /// \brief true while a trace recorder is set, lets submission skip the trace lock when not tracing
+        std::atomic<bool> m_IsTracing = false;
+
+        /// \brief if a trace recorder is set, wraps the task so that its submission and run are recorded
+        void trace_task(task_type &task)
+        {
+            if (!m_IsTracing.load(std::memory_order_relaxed)) return;
+
+            std::shared_ptr<task_trace_recorder> recorder;
+
+            {
+                std::lock_guard<std::mutex> lock(m_TraceMutex);
+
+                recorder = m_TraceRecorder;
+            }
+
+            if (!recorder) return;
+
+            const auto id = recorder->on_submit();
+
+            task = [this, recorder = std::move(recorder), id, task = std::move(task)]()
+            {
+                const auto pWorker = t_pCurrentWorker;
+
+                recorder->on_start(id, pWorker && pWorker->m_pGroup == this ? static_cast<std::int64_t>(pWorker->m_Index) : -1);
+
+                task();
+
+                recorder->on_finish(id);
+            };
+        }
+        /// \overload
+        void trace_task(std::vector<task_type> &tasks)
+        {
+            if (m_IsTracing.load(std::memory_order_relaxed)) for (auto &task : tasks) trace_task(task);
+        }
+
+        /// \brief wakes parked workers after work has been added.
+        /// the epoch increment and the parked count read are sequentially consistent, pairing with the parked count increment and epoch read in park: either the producer sees the parked worker, or the worker sees the new epoch
+        void notify_work(const size_t taskCount)
+        {
+            m_WorkEpoch.fetch_add(1);
+
+            if (m_ParkedCount.load())
+            {
+                // taking the lock orders the notify after a worker that is about to wait has evaluated its predicate
+                { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+                if (taskCount == 1) m_ParkCondition.notify_one();
+                else m_ParkCondition.notify_all();
+            }
+        }
+
+        /// \brief returns the local queue to place a task in by two choices, nullptr if tasks are to go to the shared queue
+        task_collection_type *choose_local_queue()
+        {
+            if (m_TaskPlacement.load(std::memory_order_relaxed) != task_placement_mode::two_choices) return nullptr;
+
+            const auto count = m_ActiveWorkerCount.load(std::memory_order_relaxed);
+
+            if (count < 2) return count ? &m_LocalTasks[0] : nullptr;
+
+            const auto first = random_index(count);
+
+            // the second choice is drawn from the other count - 1 queues
+            auto second = random_index(count - 1);
+
+            if (second >= first) ++second;
+
+            auto &a = m_LocalTasks[first];
+            auto &b = m_LocalTasks[second];
+
+            return b.size_approx() < a.size_approx() ? &b : &a;
+        }
+
+        /// \brief places tasks in the shared queue or, under two choices placement, in a chunk per active worker
+        void enqueue_tasks(std::vector<task_type> &tasks)
+        {
+            const auto scope = memory_scope();
+
+            const auto count = m_ActiveWorkerCount.load(std::memory_order_relaxed);
+
+            const auto chunk_size = count ? (tasks.size() + count - 1) / count : tasks.size();
+
+            for (size_t offset(0); offset < tasks.size(); offset += chunk_size)
+            {
+                const auto size = std::min(chunk_size, tasks.size() - offset);
+
+                if (auto pQueue = choose_local_queue()) pQueue->enqueue_bulk(tasks.begin() + offset, size);
+                else
+                {
+                    m_Tasks.enqueue_bulk(tasks.begin() + offset, tasks.size() - offset);
+
+                    break;
+                }
+            }
+        }
+        /// \overload
+        void enqueue_tasks(task_type &task)
+        {
+            const auto scope = memory_scope();
+
+            if (auto pQueue = choose_local_queue()) pQueue->enqueue(std::move(task));
+            else m_Tasks.enqueue(std::move(task));
+        }
+
+        /// \brief takes a task from the local queue of any thread of the group other than skipIndex, starting after it
+        bool try_dequeue_neighbour_task(task_type &task, const size_t skipIndex)
+        {
+            for (size_t i(1); i <= m_LocalTaskQueueCount; ++i)
+            {
+                const auto index = (skipIndex + i) % m_LocalTaskQueueCount;
+
+                if (index != skipIndex && m_LocalTasks[index].try_dequeue(task)) return true;
+            }
+
+            return false;
+        }
+
+        /// \brief wakes parked workers after work has been posted to a worker's mailbox.
+        /// the shared condition is not addressable per worker, so all parked workers are woken to let the recipient see its mail
+        void notify_mail()
+        {
+            m_WorkEpoch.fetch_add(1);
+
+            if (m_ParkedCount.load())
+            {
+                { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+                m_ParkCondition.notify_all();
+                m_SurplusCondition.notify_all();
+            }
+        }
+
+        /// \brief wakes every parked worker, used when the group is destroyed, the active worker count changes or a task source is added
+        void notify_all_workers()
+        {
+            m_WorkEpoch.fetch_add(1);
+
+            { std::lock_guard<std::mutex> lock(m_ParkMutex); }
+
+            m_ParkCondition.notify_all();
+            m_SurplusCondition.notify_all();
+            m_PauseCondition.notify_all();
+        }
+
+        /// \brief true if the worker is one of the group's threads and the group is paused
+        bool is_paused(const worker_data_type &worker) const
+        {
+            return !worker.m_IsExternal && m_IsPaused.load(std::memory_order_relaxed) && !m_GroupIsDestroyed.load(std::memory_order_relaxed);
+        }
+
+        /// \brief blocks a paused worker until the group is resumed or destroyed
+        void park_paused(worker_data_type &worker)
+        {
+            worker.m_TimesParked.fetch_add(1, std::memory_order_relaxed);
+
+            std::unique_lock<std::mutex> lock(m_ParkMutex);
+
+            m_PauseCondition.wait(lock, [this, &worker]() { return !is_paused(worker); });
+        }
+
+        /// \brief true if the worker is one of the group's threads and is currently surplus to the active worker count
+        bool is_surplus(const worker_data_type &worker) const
+        {
+            return !worker.m_IsExternal && worker.m_Index >= m_ActiveWorkerCount.load(std::memory_order_relaxed) && !m_GroupIsDestroyed.load(std::memory_order_relaxed);
+        }
+
+        /// \brief blocks a surplus worker until it becomes active, mail is posted to it, or the group is destroyed
+        void park_surplus(worker_data_type &worker)
+        {
+            worker.m_TimesParked.fetch_add(1, std::memory_order_relaxed);
+
+            // counted as parked so that notify_mail reaches it
+            m_ParkedCount.fetch_add(1);
+
+            {
+                std::unique_lock<std::mutex> lock(m_ParkMutex);
+
+                m_SurplusCondition.wait(lock, [this, &worker]()
+                {
+                    return !is_surplus(worker) || worker.m_Mailbox.size_approx();
+                });
+            }
+
+            m_ParkedCount.fetch_sub(1);
+        }
+
+        /// \brief blocks the worker until work is added after epoch was read, the group is destroyed, or the timeout (if any) elapses
+        void park(worker_data_type &worker, const std::uint64_t epoch, const bool hasTimeout)
+        {
+            worker.m_TimesParked.fetch_add(1, std::memory_order_relaxed);
+
+            m_ParkedCount.fetch_add(1);
+
+            {
+                std::unique_lock<std::mutex> lock(m_ParkMutex);
+
+                auto predicate = [this, epoch]()
+                {
+                    return m_WorkEpoch.load() != epoch || m_GroupIsDestroyed.load();
+                };
+
+                if (hasTimeout) m_ParkCondition.wait_for(lock, EXTERNAL_WORKER_POLL_INTERVAL, predicate);
+                else m_ParkCondition.wait(lock, predicate);
+            }
+
+            m_ParkedCount.fetch_sub(1);
+        }
+
+        /// \brief blocks a helping thread (see help) until work is added after epoch was read, the group is destroyed, or timeout elapses
+        void wait_for_work(const std::uint64_t epoch, const clock_type::duration timeout)
+        {
+            // counted as parked so that producers notify it
+            m_ParkedCount.fetch_add(1);
+
+            {
+                std::unique_lock<std::mutex> lock(m_ParkMutex);
+
+                m_ParkCondition.wait_for(lock, timeout, [this, epoch]()
+                {
+                    return m_WorkEpoch.load() != epoch || m_GroupIsDestroyed.load();
+                });
+            }
+
+            m_ParkedCount.fetch_sub(1);
+        }
+
+        /// \brief claims a worker slot for an external thread, reusing a detached slot if there is one
+        worker_data_type &attach_external_worker()
+        {
+            std::lock_guard<std::mutex> lock(m_WorkerMutex);
+
+            for (auto &worker : m_Workers) if (worker.m_IsExternal && !worker.m_IsAttached)
+            {
+                worker.m_IsAttached = true;
+
+                return worker;
+            }
+
+            const auto scope = memory_scope();
+
+            m_Workers.emplace_back(this, m_Workers.size(), true, allocate_scratch_buffer());
+
+            return m_Workers.back();
+        }
+
+        void detach_external_worker(worker_data_type &worker)
+        {
+            std::lock_guard<std::mutex> lock(m_WorkerMutex);
+
+            worker.m_IsAttached = false;
+        }
+
+        void add_deadline_tasks(std::vector<task_type> &&tasks, const deadline_type deadline)
+        {
+            trace_task(tasks);
+
+            {
+                std::lock_guard<std::mutex> lock(m_DeadlineMutex);
+
+                for (auto &task : tasks)
+                {
+                    m_DeadlineTasks.push_back({deadline, m_DeadlineSequence++, std::move(task)});
+
+                    std::push_heap(m_DeadlineTasks.begin(), m_DeadlineTasks.end());
+                }
+
+                m_DeadlineTaskCount.store(m_DeadlineTasks.size(), std::memory_order_release);
+            }
+
+            notify_work(tasks.size());
+        }
+
+        /// \brief dequeues the deadline task with the earliest deadline, dropping any that have expired along the way
+        bool try_dequeue_deadline_task(task_type &task)
+        {
+            if (!m_DeadlineTaskCount.load(std::memory_order_acquire)) return false;
+
+            std::vector<deadline_type> missed_deadlines;
+
+            deadline_missed_handler_type handler;
+
+            bool found(false);
+
+            {
+                std::lock_guard<std::mutex> lock(m_DeadlineMutex);
+
+                const auto now(clock_type::now());
+
+                while (!found && !m_DeadlineTasks.empty())
+                {
+                    std::pop_heap(m_DeadlineTasks.begin(), m_DeadlineTasks.end());
+
+                    auto &top = m_DeadlineTasks.back();
+
+                    if (top.m_Deadline < now) missed_deadlines.push_back(top.m_Deadline);
+                    else
+                    {
+                        task = std::move(top.m_Task);
+
+                        found = true;
+                    }
+
+                    m_DeadlineTasks.pop_back();
+                }
+
+                m_DeadlineTaskCount.store(m_DeadlineTasks.size(), std::memory_order_release);
+
+                if (!missed_deadlines.empty()) handler = m_DeadlineMissedHandler;
+            }
+
+            // the handler is called outside the lock so that it may submit tasks
+            if (!missed_deadlines.empty())
+            {
+                m_DroppedTaskCount.fetch_add(missed_deadlines.size(), std::memory_order_relaxed);
+
+                if (handler) for (const auto &deadline : missed_deadlines) handler(deadline);
+            }
+
+            return found;
+        }
+
+        tenant_type &get_tenant(const tenant_id_type tenant)
+        {
+            std::lock_guard<std::mutex> lock(m_TenantMutex);
+
+            if (tenant >= m_Tenants.size()) throw std::out_of_range("jfc::thread_group: unknown tenant");
+
+            return *m_Tenants[tenant];
+        }
+
+        /// \brief moves the round robin to the next tenant, crediting it with its quantum
+        void advance_tenant_cursor()
+        {
+            m_TenantCursor = (m_TenantCursor + 1) % m_Tenants.size();
+
+            auto &tenant = *m_Tenants[m_TenantCursor];
+
+            tenant.m_Deficit.fetch_add(TENANT_QUANTUM_NANOSECONDS * tenant.m_Weight, std::memory_order_relaxed);
+        }
+
+        /// \brief dequeues a tenant task by deficit round robin.
+        /// the current tenant is served until its deficit is spent or its queue empties; then the next tenant is credited and served.
+        /// if no tenant with credit has work, any tenant with work is served (debt included), keeping the workers busy
+        tenant_type *try_dequeue_tenant_task(task_type &task)
+        {
+            if (!m_TenantCount.load(std::memory_order_acquire)) return nullptr;
+
+            std::lock_guard<std::mutex> lock(m_TenantMutex);
+
+            const auto count = m_Tenants.size();
+
+            for (size_t visits(0); visits <= count; ++visits)
+            {
+                auto &tenant = *m_Tenants[m_TenantCursor];
+
+                if (tenant.m_Deficit.load(std::memory_order_relaxed) > 0)
+                {
+                    if (tenant.m_Tasks.try_dequeue(task)) return &tenant;
+
+                    // an idle tenant does not bank credit for later
+                    tenant.m_Deficit.store(0, std::memory_order_relaxed);
+                }
+
+                advance_tenant_cursor();
+            }
+
+            // from the cursor, so that the tenant after the one in debt is not always the first tenant
+            for (size_t i(0); i < count; ++i)
+            {
+                auto &tenant = *m_Tenants[(m_TenantCursor + i) % count];
+
+                if (tenant.m_Tasks.try_dequeue(task)) return &tenant;
+            }
+
+            return nullptr;
+        }
+
+        void add_task_source(task_source_type &&source)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_SourceMutex);
+
+                m_Sources.push_back(std::make_shared<task_source_type>(std::move(source)));
+
+                m_SourceCount.store(m_Sources.size(), std::memory_order_release);
+            }
+
+            // the source holds an unknown number of tasks
+            notify_all_workers();
+        }
+
+        /// \brief pulls the next chunk from the registered sources in turn, releasing those that are exhausted
+        bool try_dequeue_source_task(task_type &task)
+        {
+            if (!m_SourceCount.load(std::memory_order_acquire)) return false;
+
+            for (;;)
+            {
+                std::shared_ptr<task_source_type> pSource;
+
+                {
+                    std::lock_guard<std::mutex> lock(m_SourceMutex);
+
+                    if (m_Sources.empty()) return false;
+
+                    m_SourceCursor = (m_SourceCursor + 1) % m_Sources.size();
+
+                    pSource = m_Sources[m_SourceCursor];
+                }
+
+                // pulled outside the list lock, so that a slow generator holds up only the workers pulling from it
+                if ((*pSource)(task))
+                {
+                    trace_task(task);
+
+                    return true;
+                }
+
+                std::lock_guard<std::mutex> lock(m_SourceMutex);
+
+                // another worker may have released it already
+                const auto it = std::find(m_Sources.begin(), m_Sources.end(), pSource);
+
+                if (it != m_Sources.end()) m_Sources.erase(it);
+
+                m_SourceCount.store(m_Sources.size(), std::memory_order_release);
+            }
+        }
+
+        /// \brief runs a tenant task, charging the tenant for the time taken, or a quantum under tenant_charge_mode::task_count
+        void run_tenant_task(tenant_type &tenant, task_type &task)
+        {
+            if (m_TenantCharging.load(std::memory_order_relaxed) == tenant_charge_mode::task_count)
+            {
+                task();
+
+                tenant.m_Deficit.fetch_sub(TENANT_QUANTUM_NANOSECONDS, std::memory_order_relaxed);
+
+                return;
+            }
+
+            const auto start_time(std::chrono::steady_clock::now());
+
+            task();
+
+            const auto elapsed(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time));
+
+            tenant.m_Deficit.fetch_sub(elapsed.count(), std::memory_order_relaxed);
+        }
+
+        /// \brief dequeues the next task: deadline tasks first, then the local queue of pWorker (if any), the shared queue, the tenant queues, if scanNeighbours the other local queues, and last the task sources.
+        /// if the task belongs to a tenant, pTenant is set so the tenant can be charged for running it
+        bool try_dequeue_task(task_type &task, tenant_type *&pTenant, const worker_data_type *pWorker = nullptr, const bool scanNeighbours = true)
+        {
+            pTenant = nullptr;
+
+            if (try_dequeue_deadline_task(task)) return true;
+
+            const auto local_tasks_in_use = m_LocalTasksInUse.load(std::memory_order_relaxed);
+
+            // external workers have no local queue, their index is past the group's threads
+            const auto local_index = pWorker && !pWorker->m_IsExternal ? pWorker->m_Index : m_LocalTaskQueueCount;
+
+            if (local_tasks_in_use && local_index < m_LocalTaskQueueCount && m_LocalTasks[local_index].try_dequeue(task)) return true;
+
+            if (m_Tasks.try_dequeue(task)) return true;
+
+            pTenant = try_dequeue_tenant_task(task);
+
+            if (pTenant) return true;
+
+            if (local_tasks_in_use && scanNeighbours && try_dequeue_neighbour_task(task, local_index)) return true;
+
+            return try_dequeue_source_task(task);
+        }
+
+        /// \brief dequeues and runs a single task, returns false if no task was available
+        bool try_run_task(task_type &task, const worker_data_type *pWorker, const bool scanNeighbours)
+        {
+            tenant_type *pTenant;
+
+            if (!try_dequeue_task(task, pTenant, pWorker, scanNeighbours)) return false;
+
+            if (pTenant) run_tenant_task(*pTenant, task);
+            else task();
+
+            return true;
+        }
+
+        /// \brief as try_run_task, but first checks the worker's mailbox
+        bool try_run_worker_task(worker_data_type &worker, task_type &task, const bool scanNeighbours)
+        {
+            if (worker.m_Mailbox.try_dequeue(task))
+            {
+                task();
+
+                return true;
+            }
+
+            return try_run_task(task, &worker, scanNeighbours);
+        }
+
+        /// \brief the loop of a thread helping without a worker slot, see run_until. Runs tasks until the stop condition (if any) is met or the deadline (if any) passes
+        /// \return the number of tasks run
+        size_t help(const stop_condition_type &stopCondition, const deadline_type *pDeadline);
+
+        /// \brief the worker loop, run by the group's threads and by external threads attached via run_as_worker.
+        /// runs tasks until the group is destroyed and there is no work left, or until the (optional) stop condition is met
+        /// \return the number of tasks run
+        size_t work(worker_data_type &worker, const stop_condition_type &stopCondition);
+
+        /// \brief the worker slot of the calling thread, if it is currently working for a group
+        static thread_local worker_data_type *t_pCurrentWorker;
+    };
+
+    thread_local thread_group::shared_data_type::worker_data_type *thread_group::shared_data_type::t_pCurrentWorker = nullptr;
+
+    size_t thread_group::shared_data_type::work(worker_data_type &worker, const stop_condition_type &stopCondition)
+    {
+        // saved rather than cleared on exit, since a task may itself call run_as_worker
+        const auto pPreviousWorker = t_pCurrentWorker;
+
+        t_pCurrentWorker = &worker;
+
+        const scratch_arena::current_scope arena_scope(&worker.m_ScratchArena);
+
+        thread_group::task_type task;
+
+        size_t tasks_executed(0), idle_count(0);
+
+        // true if the worker was woken by new work that it has not yet looked for
+        bool is_woken(false);
+
+        for (;;)
+        {
+            if (stopCondition && stopCondition())
+            {
+                // an external worker parks alongside the group's, so may have absorbed a notification meant for one of them, pass it on
+                if (is_woken) notify_work(1);
+
+                break;
+            }
+
+            if (is_paused(worker))
+            {
+                park_paused(worker);
+
+                idle_count = 0;
+
+                continue;
+            }
+
+            if (is_surplus(worker))
+            {
+                if (worker.m_Mailbox.try_dequeue(task))
+                {
+                    task();
+
+                    worker.m_ScratchArena.reset();
+
+                    worker.m_TasksExecuted.fetch_add(1, std::memory_order_relaxed);
+
+                    ++tasks_executed;
+                }
+                else park_surplus(worker);
+
+                idle_count = 0;
+
+                continue;
+            }
+
+            const auto epoch = m_WorkEpoch.load();
+
+            is_woken = false;
+
+            // the attempt before parking always looks in the other queues, so that a task placed in the queue of a busy or parked worker is found by whichever worker is woken for it
+            const auto scan_neighbours = idle_count % NEIGHBOUR_SCAN_INTERVAL == 0 || idle_count + 1 >= PARK_SPIN_COUNT;
+
+            if (try_run_worker_task(worker, task, scan_neighbours))
+            {
+                worker.m_ScratchArena.reset();
+
+                worker.m_TasksExecuted.fetch_add(1, std::memory_order_relaxed);
+
+                ++tasks_executed;
+
+                idle_count = 0;
+            }
+            else if (m_GroupIsDestroyed.load(std::memory_order_relaxed)) break;
+            else if (++idle_count < PARK_SPIN_COUNT) std::this_thread::yield();
+            else
+            {
+                park(worker, epoch, static_cast<bool>(stopCondition));
+
+                is_woken = m_WorkEpoch.load() != epoch;
+
+                idle_count = 0;
+            }
+        }
+
+        t_pCurrentWorker = pPreviousWorker;
+
+        return tasks_executed;
+    }
+
+    size_t thread_group::shared_data_type::help(const stop_condition_type &stopCondition, const deadline_type *pDeadline)
+    {
+        thread_group::task_type task;
+
+        size_t tasks_executed(0), idle_count(0);
+
+        // true if the thread was woken by new work that it has not yet looked for
+        bool is_woken(false);
+
+        for (;;)
+        {
+            const auto now(clock_type::now());
+
+            if ((stopCondition && stopCondition()) || (pDeadline && now >= *pDeadline))
+            {
+                // a notification meant for a worker may have been absorbed by this thread, pass it on
+                if (is_woken) notify_work(1);
+
+                break;
+            }
+
+            const auto epoch = m_WorkEpoch.load();
+
+            is_woken = false;
+
+            if (try_run_task(task, nullptr, true))
+            {
+                ++tasks_executed;
+
+                idle_count = 0;
+            }
+            else if (++idle_count < PARK_SPIN_COUNT) std::this_thread::yield();
+            else
+            {
+                clock_type::duration timeout = EXTERNAL_WORKER_POLL_INTERVAL;
+
+                if (pDeadline) timeout = stopCondition ? std::min<clock_type::duration>(timeout, *pDeadline - now) : *pDeadline - now;
+
+                wait_for_work(epoch, timeout);
+
+                is_woken = m_WorkEpoch.load() != epoch;
+
+                idle_count = 0;
+            }
+        }
+
+        return tasks_executed;
+    }
+
+    void thread_group::pause()
+    {
+        m_SharedData->m_IsPaused = true;
+    }
+
+    void thread_group::resume()
+    {
+        m_SharedData->m_IsPaused = false;
+
+        { std::lock_guard<std::mutex> lock(m_SharedData->m_ParkMutex); }
+
+        m_SharedData->m_PauseCondition.notify_all();
+    }
+
+    bool thread_group::is_paused() const
+    {
+        return m_SharedData->m_IsPaused.load();
+    }
+
+    size_t thread_group::thread_count() const
+    {
+        return m_Threads.size();
+    }
+    
+    void thread_group::add_tasks(std::vector<thread_group::task_type> &&tasks)
+    {
+        if (m_SharedData->should_run_inline()) return m_SharedData->run_inline(tasks);
+
+        m_SharedData->trace_task(tasks);
+
+        m_SharedData->enqueue_tasks(tasks);
+
+        m_SharedData->notify_work(tasks.size());
+    }
+    void thread_group::add_tasks(thread_group::task_type &&task)
+    {
+        if (m_SharedData->should_run_inline()) return m_SharedData->run_inline(task);
+
+        m_SharedData->trace_task(task);
+
+        m_SharedData->enqueue_tasks(task);
+
+        m_SharedData->notify_work(1);
+    }
+
+    thread_group::tenant_id_type thread_group::add_tenant(const size_t weight)
+    {
+        if (!weight) throw std::invalid_argument("jfc::thread_group: tenant weight must be nonzero");
+
+        auto &shared = *m_SharedData;
+
+        std::lock_guard<std::mutex> lock(shared.m_TenantMutex);
+
+        const auto scope = shared.memory_scope();
+
+        shared.m_Tenants.push_back(std::make_unique<shared_data_type::tenant_type>(static_cast<std::int64_t>(weight)));
+
+        if (shared.m_Tenants.size() == 1) shared.m_Tenants.front()->m_Deficit = TENANT_QUANTUM_NANOSECONDS * shared.m_Tenants.front()->m_Weight;
+
+        shared.m_TenantCount.store(shared.m_Tenants.size(), std::memory_order_release);
+
+        return shared.m_Tenants.size() - 1;
+    }
+
+    void thread_group::add_tasks(const tenant_id_type tenant, std::vector<thread_group::task_type> &&tasks)
+    {
+        auto &tenant_data = m_SharedData->get_tenant(tenant);
+
+        if (m_SharedData->should_run_inline()) return m_SharedData->run_inline(tasks);
+
+        m_SharedData->trace_task(tasks);
+
+        const auto scope = m_SharedData->memory_scope();
+
+        tenant_data.m_Tasks.enqueue_bulk(tasks.begin(), tasks.size());
+
+        m_SharedData->notify_work(tasks.size());
+    }
+    void thread_group::add_tasks(const tenant_id_type tenant, thread_group::task_type &&task)
+    {
+        auto &tenant_data = m_SharedData->get_tenant(tenant);
+
+        if (m_SharedData->should_run_inline()) return m_SharedData->run_inline(task);
+
+        m_SharedData->trace_task(task);
+
+        const auto scope = m_SharedData->memory_scope();
+
+        tenant_data.m_Tasks.enqueue(std::move(task));
+
+        m_SharedData->notify_work(1);
+    }
+
+    void thread_group::add_tasks(std::vector<thread_group::task_type> &&tasks, const deadline_type deadline)
+    {
+        if (m_SharedData->should_run_inline()) return m_SharedData->run_inline(tasks, deadline);
 
-        /// \brief tasks are placed here and consumed by threads in the group.
-        task_collection_type m_Tasks;
+        m_SharedData->add_deadline_tasks(std::move(tasks), deadline);
+    }
+    void thread_group::add_tasks(thread_group::task_type &&task, const deadline_type deadline)
+    {
+        std::vector<task_type> tasks;
 
-        /// \brief exit flag for the worker's loops. When the group falls out of scope (ignoring moves), the threads are told to exit.
-        std::atomic<bool> m_GroupIsDestroyed = false;
-    };
+        tasks.push_back(std::move(task));
 
-    size_t thread_group::thread_count() const
+        add_tasks(std::move(tasks), deadline);
+    }
+
+    void thread_group::set_tenant_charging(const tenant_charge_mode mode)
     {
-        return m_Threads.size();
+        m_SharedData->m_TenantCharging = mode;
     }
-    
-    void thread_group::add_tasks(std::vector<thread_group::task_type> &&tasks)
+
+    thread_group::tenant_charge_mode thread_group::tenant_charging() const
     {
-        m_SharedData->m_Tasks.enqueue_bulk(tasks.begin(), tasks.size());
+        return m_SharedData->m_TenantCharging.load();
     }
-    void thread_group::add_tasks(thread_group::task_type &&task)
+
+    void thread_group::set_inline_execution(const inline_execution_mode mode)
+    {
+        m_SharedData->m_InlineExecution = mode;
+    }
+
+    thread_group::inline_execution_mode thread_group::inline_execution() const
+    {
+        return m_SharedData->m_InlineExecution.load();
+    }
+
+    void thread_group::add_task_source(task_generator_type generator, const size_t chunkSize)
+    {
+        if (!chunkSize) throw std::invalid_argument("jfc::thread_group: task source chunk size must be nonzero");
+
+        struct generator_state_type
+        {
+            std::mutex m_Mutex;
+
+            task_generator_type m_Generator;
+
+            bool m_IsExhausted = false;
+        };
+
+        auto state = std::make_shared<generator_state_type>();
+
+        state->m_Generator = std::move(generator);
+
+        shared_data_type::task_source_type source = [state, chunkSize](task_type &task)
+        {
+            std::vector<task_type> chunk;
+
+            {
+                std::lock_guard<std::mutex> lock(state->m_Mutex);
+
+                while (!state->m_IsExhausted && chunk.size() < chunkSize)
+                {
+                    if (auto next = state->m_Generator()) chunk.push_back(std::move(*next));
+                    else
+                    {
+                        state->m_IsExhausted = true;
+
+                        // releases whatever the generator holds as soon as the stream ends
+                        state->m_Generator = nullptr;
+                    }
+                }
+            }
+
+            if (chunk.empty()) return false;
+
+            if (chunk.size() == 1) task = std::move(chunk.front());
+            else task = [chunk = std::move(chunk)]()
+            {
+                for (const auto &t : chunk) t();
+            };
+
+            return true;
+        };
+
+        if (m_SharedData->should_run_inline())
+        {
+            for (task_type task; source(task);) task();
+
+            return;
+        }
+
+        m_SharedData->add_task_source(std::move(source));
+    }
+    void thread_group::add_task_source(const size_t count, index_task_type body, const size_t chunkSize)
+    {
+        if (!chunkSize) throw std::invalid_argument("jfc::thread_group: task source chunk size must be nonzero");
+
+        if (m_SharedData->should_run_inline())
+        {
+            for (size_t i(0); i < count; ++i) body(i);
+
+            return;
+        }
+
+        auto pBody = std::make_shared<index_task_type>(std::move(body));
+
+        auto pCursor = std::make_shared<std::atomic<size_t>>(0);
+
+        m_SharedData->add_task_source([pBody, pCursor, count, chunkSize](task_type &task)
+        {
+            // bounded by count so that pulls after exhaustion cannot wrap the cursor around
+            auto begin = pCursor->load(std::memory_order_relaxed);
+
+            size_t end;
+
+            do
+            {
+                if (begin >= count) return false;
+
+                end = begin + std::min(chunkSize, count - begin);
+            }
+            while (!pCursor->compare_exchange_weak(begin, end, std::memory_order_relaxed));
+
+            task = [pBody, begin, end]()
+            {
+                for (auto i = begin; i < end; ++i) (*pBody)(i);
+            };
+
+            return true;
+        });
+    }
+
+    void thread_group::set_task_placement(const task_placement_mode mode)
+    {
+        if (mode == task_placement_mode::two_choices) m_SharedData->m_LocalTasksInUse = true;
+
+        m_SharedData->m_TaskPlacement = mode;
+    }
+
+    thread_group::task_placement_mode thread_group::task_placement() const
     {
-        m_SharedData->m_Tasks.enqueue(std::move(task));
+        return m_SharedData->m_TaskPlacement.load();
+    }
+
+    void thread_group::set_deadline_missed_handler(deadline_missed_handler_type handler)
+    {
+        std::lock_guard<std::mutex> lock(m_SharedData->m_DeadlineMutex);
+
+        m_SharedData->m_DeadlineMissedHandler = std::move(handler);
+    }
+
+    size_t thread_group::dropped_task_count() const
+    {
+        return m_SharedData->m_DroppedTaskCount.load(std::memory_order_relaxed);
     }
 
     std::optional<thread_group::task_type> thread_group::try_get_task()
     {
         thread_group::task_type task;
 
-        if (m_SharedData->m_Tasks.try_dequeue(task)) return task;
+        shared_data_type::tenant_type *pTenant;
+
+        if (!m_SharedData->try_dequeue_task(task, pTenant)) return {};
+
+        if (pTenant)
+        {
+            // the shared data is captured so the tenant outlives the functor, as with the rest of the queue
+            return [shared = m_SharedData, pTenant, task = std::move(task)]() mutable
+            {
+                shared->run_tenant_task(*pTenant, task);
+            };
+        }
+
+        return task;
+    }
+
+    std::vector<thread_group::task_type> thread_group::try_get_tasks(const size_t maxCount)
+    {
+        std::vector<task_type> tasks;
+
+        tasks.reserve(maxCount);
+
+        // deadline tasks come first, as with try_get_task
+        task_type task;
+
+        while (tasks.size() < maxCount && m_SharedData->try_dequeue_deadline_task(task)) tasks.push_back(std::move(task));
+
+        if (tasks.size() < maxCount) m_SharedData->m_Tasks.try_dequeue_bulk(std::back_inserter(tasks), maxCount - tasks.size());
+
+        while (tasks.size() < maxCount)
+        {
+            auto next = try_get_task();
+
+            if (!next) break;
+
+            tasks.push_back(std::move(*next));
+        }
+
+        return tasks;
+    }
+
+    bool thread_group::run_one()
+    {
+        task_type task;
+
+        return m_SharedData->try_run_task(task, nullptr, true);
+    }
+
+    size_t thread_group::run_for(const clock_type::duration duration)
+    {
+        const auto deadline = clock_type::now() + duration;
+
+        return m_SharedData->help({}, &deadline);
+    }
+
+    size_t thread_group::run_until(const stop_condition_type &stopCondition)
+    {
+        return m_SharedData->help(stopCondition, nullptr);
+    }
+
+    void thread_group::broadcast(const task_type &f, const broadcast_mode mode)
+    {
+        const auto worker_count = m_Threads.size();
+
+        if (!worker_count) return;
+
+        auto &shared = *m_SharedData;
+
+        task_type task;
+
+        if (mode == broadcast_mode::barrier)
+        {
+            auto pBarrier = std::make_shared<shared_data_type::barrier_type>();
+            pBarrier->m_Functor = f;
+            pBarrier->m_Remaining = worker_count;
+
+            {
+                std::lock_guard<std::mutex> lock(shared.m_BarrierMutex);
+
+                shared.m_Barriers.emplace(shared.m_NextBarrierSequence++, std::move(pBarrier));
+            }
+
+            const auto pShared = &shared;
+
+            task = [pShared]() { pShared->run_next_barrier(); };
+        }
+        else
+        {
+            const auto pFunctor = std::make_shared<task_type>(f);
+
+            task = [pFunctor]() { (*pFunctor)(); };
+        }
+
+        // the slot collection may be growing as external threads attach
+        std::unique_lock<std::mutex> workers_lock(shared.m_WorkerMutex);
+
+        const auto scope = shared.memory_scope();
+
+        for (size_t i(0); i < worker_count; ++i) shared.m_Workers[i].m_Mailbox.enqueue(task_type(task));
+
+        workers_lock.unlock();
+
+        shared.notify_mail();
+    }
+
+    void thread_group::add_task_to(const size_t workerIndex, task_type &&task)
+    {
+        if (workerIndex >= m_Threads.size()) throw std::out_of_range("jfc::thread_group: worker index out of range");
+
+        auto &shared = *m_SharedData;
+
+        shared.trace_task(task);
+
+        {
+            std::lock_guard<std::mutex> lock(shared.m_WorkerMutex);
+
+            const auto scope = shared.memory_scope();
+
+            shared.m_Workers[workerIndex].m_Mailbox.enqueue(std::move(task));
+        }
+
+        shared.notify_mail();
+    }
+
+    size_t thread_group::run_as_worker(const stop_condition_type &stopCondition)
+    {
+        // held for the duration of the call, the group may be destroyed by another thread while this one is attached
+        auto shared = m_SharedData;
+
+        auto &worker = shared->attach_external_worker();
+
+        const auto tasks_executed = shared->work(worker, stopCondition);
+
+        shared->detach_external_worker(worker);
+
+        return tasks_executed;
+    }
+
+    std::optional<size_t> thread_group::current_worker_index() const
+    {
+        const auto pWorker = shared_data_type::t_pCurrentWorker;
+
+        if (pWorker && pWorker->m_pGroup == m_SharedData.get()) return pWorker->m_Index;
 
         return {};
     }
 
+    void thread_group::set_trace_recorder(std::shared_ptr<task_trace_recorder> recorder)
+    {
+        std::lock_guard<std::mutex> lock(m_SharedData->m_TraceMutex);
+
+        m_SharedData->m_IsTracing.store(static_cast<bool>(recorder), std::memory_order_relaxed);
+
+        m_SharedData->m_TraceRecorder = std::move(recorder);
+    }
+
+    void thread_group::set_active_worker_count(const size_t count)
+    {
+        if (count > m_Threads.size()) throw std::out_of_range("jfc::thread_group: active worker count exceeds thread count");
+
+        m_SharedData->m_ActiveWorkerCount.store(count, std::memory_order_relaxed);
+
+        m_SharedData->notify_all_workers();
+    }
+
+    size_t thread_group::active_worker_count() const
+    {
+        return m_SharedData->m_ActiveWorkerCount.load(std::memory_order_relaxed);
+    }
+
+    size_t thread_group::completed_task_count() const
+    {
+        std::lock_guard<std::mutex> lock(m_SharedData->m_WorkerMutex);
+
+        size_t count(0);
+
+        for (const auto &worker : m_SharedData->m_Workers) count += worker.m_TasksExecuted.load(std::memory_order_relaxed);
+
+        return count;
+    }
+
+    thread_group::worker_stats_collection_type thread_group::worker_stats() const
+    {
+        worker_stats_collection_type stats;
+
+        std::lock_guard<std::mutex> lock(m_SharedData->m_WorkerMutex);
+
+        stats.reserve(m_SharedData->m_Workers.size());
+
+        for (const auto &worker : m_SharedData->m_Workers) stats.push_back({
+            worker.m_Index,
+            worker.m_TasksExecuted.load(std::memory_order_relaxed),
+            worker.m_TimesParked.load(std::memory_order_relaxed),
+            worker.m_IsExternal});
+
+        return stats;
+    }
+
     thread_group::thread_id_collection_type thread_group::thread_ids() const
     {
         return m_Thread_IDs;
     }
 
+    class thread_group::thread_type final
+    {
+            /// \brief used when no stack size is requested, or where pthreads are unavailable
+            std::thread m_Thread;
+
+#ifdef JFC_THREAD_GROUP_USES_PTHREADS
+            pthread_t m_NativeThread;
+
+            bool m_IsNative = false;
+
+            static void *native_main(void *pBody)
+            {
+                std::unique_ptr<task_type> body(static_cast<task_type *>(pBody));
+
+                (*body)();
+
+                return nullptr;
+            }
+#endif
+
+        public:
+            void join()
+            {
+#ifdef JFC_THREAD_GROUP_USES_PTHREADS
+                if (m_IsNative)
+                {
+                    pthread_join(m_NativeThread, nullptr);
+
+                    return;
+                }
+#endif
+                m_Thread.join();
+            }
+
+            /// \brief starts a thread running body, with a stack of stackSize bytes if nonzero
+            /// \throws std::system_error if the thread cannot be created
+            thread_type(const size_t stackSize, task_type &&body)
+            {
+#ifdef JFC_THREAD_GROUP_USES_PTHREADS
+                if (stackSize)
+                {
+                    const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+                    const auto size = (std::max<size_t>(stackSize, PTHREAD_STACK_MIN) + page_size - 1) / page_size * page_size;
+
+                    pthread_attr_t attributes;
+
+                    pthread_attr_init(&attributes);
+
+                    auto error = pthread_attr_setstacksize(&attributes, size);
+
+                    auto pBody = new task_type(std::move(body));
+
+                    if (!error) error = pthread_create(&m_NativeThread, &attributes, &native_main, pBody);
+
+                    pthread_attr_destroy(&attributes);
+
+                    if (error)
+                    {
+                        delete pBody;
+
+                        throw std::system_error(error, std::generic_category(), "jfc::thread_group: could not create a thread");
+                    }
+
+                    m_IsNative = true;
+
+                    return;
+                }
+#endif
+                (void)stackSize;
+
+                m_Thread = std::thread(std::move(body));
+            }
+    };
+
+    /// \brief applies the name and scheduling attributes to the calling thread
+    /// \throws std::system_error if the scheduling attributes are refused
+    static void apply_thread_attributes(const thread_group::thread_attributes_type &attributes, const size_t index)
+    {
+#if defined(__linux__)
+        using policy = thread_group::thread_attributes_type::scheduling_policy_type;
+
+        if (!attributes.name.empty())
+        {
+            // the kernel keeps 15 characters; the index is kept so that threads stay distinguishable
+            static constexpr size_t MAX_NAME_LENGTH = 15;
+
+            const auto suffix = std::to_string(index);
+
+            const auto name = attributes.name.substr(0, MAX_NAME_LENGTH - std::min(suffix.size(), MAX_NAME_LENGTH)) + suffix;
+
+            pthread_setname_np(pthread_self(), name.c_str());
+        }
+
+        sched_param parameters{};
+
+        switch (attributes.scheduling_policy)
+        {
+            case policy::normal:
+            {
+                // on Linux nice values are per thread, addressed by thread id
+                if (attributes.nice && setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), attributes.nice) < 0)
+                    throw std::system_error(errno, std::generic_category(), "jfc::thread_group: could not set the nice value of a thread");
+            } break;
+
+            case policy::idle:
+            {
+                if (const auto error = pthread_setschedparam(pthread_self(), SCHED_IDLE, &parameters))
+                    throw std::system_error(error, std::generic_category(), "jfc::thread_group: could not apply the idle policy to a thread");
+            } break;
+
+            case policy::fifo:
+            {
+                parameters.sched_priority = attributes.realtime_priority;
+
+                if (const auto error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters))
+                    throw std::system_error(error, std::generic_category(), "jfc::thread_group: could not apply the fifo policy to a thread");
+            } break;
+        }
+#else
+        (void)attributes;
+        (void)index;
+#endif
+    }
+
     thread_group &thread_group::operator=(thread_group &&b) 
     {
         m_SharedData = std::move(b.m_SharedData);
@@ -61,29 +1681,80 @@ namespace jfc
     thread_group::thread_group(thread_group &&b) { (*this) = std::move(b); }
 
     thread_group::thread_group(size_t threadNumber) 
-    : m_SharedData(std::make_shared<shared_data_type>())
+    : thread_group(threadNumber, thread_attributes_type())
+    {}
+
+    thread_group::thread_group(size_t threadNumber, const thread_attributes_type &attributes)
+    : thread_group(threadNumber, attributes, memory_attributes_type())
+    {}
+
+    thread_group::thread_group(size_t threadNumber, const thread_attributes_type &attributes, const memory_attributes_type &memory)
+    : m_SharedData(shared_data_type::make(memory))
     {
+        if (attributes.nice < -20 || attributes.nice > 19) throw std::invalid_argument("jfc::thread_group: nice value must be in [-20, 19]");
+
+        if (attributes.scheduling_policy == thread_attributes_type::scheduling_policy_type::fifo && (attributes.realtime_priority < 1 || attributes.realtime_priority > 99))
+            throw std::invalid_argument("jfc::thread_group: realtime priority must be in [1, 99]");
+
         m_Threads.reserve(threadNumber);
 
         auto shared = m_SharedData;   
 
-        for (decltype(threadNumber) i(0); i < threadNumber; ++i) 
         {
-            m_Threads.push_back(std::thread([shared]()
+            const auto scope = shared->memory_scope();
+
+            for (decltype(threadNumber) i(0); i < threadNumber; ++i) shared->m_Workers.emplace_back(shared.get(), i, false, shared->allocate_scratch_buffer());
+
+            shared->m_LocalTasks = std::make_unique<shared_data_type::task_collection_type[]>(threadNumber);
+        }
+
+        shared->m_LocalTaskQueueCount = threadNumber;
+
+        shared->m_ActiveWorkerCount = threadNumber;
+
+        // each thread reports its id once its attributes are applied, or the reason they could not be
+        std::vector<std::future<std::thread::id>> started;
+
+        started.reserve(threadNumber);
+
+        try
+        {
+            for (decltype(threadNumber) i(0); i < threadNumber; ++i) 
             {
-                thread_group::task_type task;
+                auto pStarted = std::make_shared<std::promise<std::thread::id>>();
 
-                for (;;)
+                started.push_back(pStarted->get_future());
+
+                m_Threads.push_back(std::make_unique<thread_type>(attributes.stack_size, [shared, &worker = shared->m_Workers[i], attributes, i, pStarted]()
                 {
-                    if (shared->m_Tasks.try_dequeue(task))
-                    {   
-                        task();
+                    try
+                    {
+                        apply_thread_attributes(attributes, i);
+                    }
+                    catch (...)
+                    {
+                        pStarted->set_exception(std::current_exception());
+
+                        return;
                     }
-                    else if (shared->m_GroupIsDestroyed.load(std::memory_order_relaxed)) break;
-                }
-            }));
 
-            m_Thread_IDs.push_back(m_Threads.back().get_id());
+                    pStarted->set_value(std::this_thread::get_id());
+
+                    shared->work(worker, {});
+                }));
+            }
+
+            for (auto &id : started) m_Thread_IDs.push_back(id.get());
+        }
+        catch (...)
+        {
+            shared->m_GroupIsDestroyed = true;
+
+            shared->notify_all_workers();
+
+            for (auto &pThread : m_Threads) pThread->join();
+
+            throw;
         }
     }
     
@@ -95,11 +1766,13 @@ namespace jfc
 
     thread_group::~thread_group()
     {  
-        if (!m_Threads.empty())
+        if (m_SharedData)
         {
             m_SharedData->m_GroupIsDestroyed = true;
 
-            for (auto &current_thread : m_Threads) current_thread.join();
+            m_SharedData->notify_all_workers();
+
+            for (auto &pThread : m_Threads) pThread->join();
         }
     }
 }
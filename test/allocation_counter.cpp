@@ -0,0 +1,31 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/// \brief the replacement allocation functions are global to the test executable, so they are defined once here for every test that counts
+static std::atomic<size_t> g_AllocationCount(0);
+
+void *operator new(size_t size)
+{
+    g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto p = std::malloc(size ? size : 1)) return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace jfc_test
+{
+    size_t allocation_count()
+    {
+        return g_AllocationCount.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,14 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#ifndef JFC_TEST_ALLOCATION_COUNTER_H
+#define JFC_TEST_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+namespace jfc_test
+{
+    /// \brief get the number of calls to the global allocation functions so far, so tests can check a section of code performs none
+    size_t allocation_count();
+}
+
+#endif
@@ -0,0 +1,142 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/concurrency_controller.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+TEST_CASE( "jfc::concurrency_controller test", "[jfc::concurrency_controller]" )
+{
+    SECTION("hill climbing finds the optimum worker count and follows it when it moves")
+    {
+        jfc::hill_climbing_policy::options_type options;
+
+        options.min_worker_count = 1;
+        options.max_worker_count = 16;
+        options.noise_threshold = 0.02;
+
+        jfc::hill_climbing_policy policy(options);
+
+        // a synthetic workload, e.g. memory bound, whose throughput falls off either side of its best worker count.
+        // falls within the noise threshold do not turn the search, so it probes up to two steps past the optimum
+        size_t optimum(6);
+
+        const auto throughput = [&optimum](const size_t workers)
+        {
+            const auto distance = static_cast<double>(workers) - static_cast<double>(optimum);
+
+            return 1000 - 20 * distance * distance;
+        };
+
+        size_t workers(1);
+
+        for (int step(0); step < 30; ++step) workers = policy.next_worker_count(workers, throughput(workers));
+
+        for (int step(0); step < 20; ++step)
+        {
+            workers = policy.next_worker_count(workers, throughput(workers));
+
+            REQUIRE(workers + 2 >= optimum);
+            REQUIRE(workers <= optimum + 2);
+        }
+
+        optimum = 12;
+
+        for (int step(0); step < 30; ++step) workers = policy.next_worker_count(workers, throughput(workers));
+
+        for (int step(0); step < 20; ++step)
+        {
+            workers = policy.next_worker_count(workers, throughput(workers));
+
+            REQUIRE(workers + 2 >= optimum);
+            REQUIRE(workers <= optimum + 2);
+        }
+
+        optimum = 2;
+
+        for (int step(0); step < 30; ++step) workers = policy.next_worker_count(workers, throughput(workers));
+
+        for (int step(0); step < 20; ++step)
+        {
+            workers = policy.next_worker_count(workers, throughput(workers));
+
+            REQUIRE(workers + 2 >= optimum);
+            REQUIRE(workers <= optimum + 2);
+        }
+    }
+
+    SECTION("the policy stays within its bounds")
+    {
+        jfc::hill_climbing_policy::options_type options;
+
+        options.min_worker_count = 2;
+        options.max_worker_count = 4;
+
+        jfc::hill_climbing_policy policy(options);
+
+        size_t workers(2);
+
+        // throughput that always rises would push past the maximum
+        for (int step(0); step < 20; ++step)
+        {
+            workers = policy.next_worker_count(workers, 100.0 * step);
+
+            REQUIRE(workers >= 2);
+            REQUIRE(workers <= 4);
+        }
+
+        options.min_worker_count = 5;
+
+        REQUIRE_THROWS_AS(jfc::hill_climbing_policy(options), std::invalid_argument);
+    }
+
+    SECTION("a controller adjusts a live group and restores it on destruction")
+    {
+        jfc::thread_group group(4);
+
+        std::atomic<bool> done(false);
+
+        std::atomic<size_t> smallest_active(group.thread_count());
+
+        {
+            jfc::hill_climbing_policy::options_type options;
+
+            options.min_worker_count = 1;
+
+            jfc::concurrency_controller controller(group, options, std::chrono::milliseconds(2));
+
+            std::thread producer([&]()
+            {
+                while (!done)
+                {
+                    for (int i(0); i < 64; ++i) group.add_tasks([]()
+                    {
+                        volatile int sink(0);
+
+                        for (int j(0); j < 1000; ++j) sink = sink + j;
+                    });
+
+                    smallest_active = std::min(smallest_active.load(), group.active_worker_count());
+
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            done = true;
+
+            producer.join();
+        }
+
+        REQUIRE(smallest_active < group.thread_count());
+        REQUIRE(group.active_worker_count() == group.thread_count());
+
+        REQUIRE_THROWS_AS(jfc::concurrency_controller(*std::make_unique<jfc::thread_group>(0), {}), std::invalid_argument);
+    }
+}
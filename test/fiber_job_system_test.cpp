@@ -0,0 +1,125 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/fiber_job_system.h>
+
+#ifdef JFC_FIBERS_SUPPORTED
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE( "jfc::fiber_job_system test", "[jfc::fiber_job_system]" )
+{
+    jfc::thread_group group(4);
+
+    jfc::fiber_job_system jobs(group, 16);
+
+    SECTION("jobs run and decrement their counter, which can be waited on from outside a job")
+    {
+        jfc::fiber_job_system::counter counter;
+
+        std::atomic<int> run_count(0);
+
+        jobs.run_jobs({100, [&run_count]() { run_count.fetch_add(1); }}, &counter);
+
+        jobs.wait_for_counter(counter);
+
+        REQUIRE(run_count == 100);
+        REQUIRE(counter.value() == 0);
+    }
+
+    SECTION("a job can wait on jobs it spawns without blocking its worker")
+    {
+        const int DEPTH(200);
+
+        // each job spawns the next and waits for it, so the whole chain is suspended at once: far more fibers than threads
+        jfc::fiber_job_system jobs(group, DEPTH + 1);
+
+        std::vector<int> order;
+
+        std::function<void(int)> spawn_chain = [&](const int depth)
+        {
+            if (depth < DEPTH)
+            {
+                jfc::fiber_job_system::counter child;
+
+                jobs.run_jobs([&spawn_chain, depth]() { spawn_chain(depth + 1); }, &child);
+
+                jobs.wait_for_counter(child);
+            }
+
+            order.push_back(depth);
+        };
+
+        jfc::fiber_job_system::counter root;
+
+        jobs.run_jobs([&spawn_chain]() { spawn_chain(0); }, &root);
+
+        jobs.wait_for_counter(root);
+
+        REQUIRE(order.size() == DEPTH + 1);
+
+        for (int i(0); i <= DEPTH; ++i) REQUIRE(order[i] == DEPTH - i);
+    }
+
+    SECTION("waiting jobs free their worker: more jobs can wait than there are threads")
+    {
+        REQUIRE(jobs.fiber_count() == 16);
+
+        jfc::fiber_job_system::counter gate, counter;
+
+        std::atomic<int> arrived_count(0), run_count(0);
+
+        jobs.run_jobs([&arrived_count]()
+        {
+            while (arrived_count < 15) std::this_thread::yield();
+        }, &gate);
+
+        jobs.run_jobs({15, [&]()
+        {
+            arrived_count.fetch_add(1);
+
+            jobs.wait_for_counter(gate);
+
+            run_count.fetch_add(1);
+        }}, &counter);
+
+        jobs.wait_for_counter(counter);
+
+        REQUIRE(run_count == 15);
+    }
+
+    SECTION("fibers are reused once their job completes")
+    {
+        jfc::fiber_job_system::counter counter;
+
+        std::atomic<int> run_count(0);
+
+        jobs.run_jobs({1000, [&run_count]() { run_count.fetch_add(1); }}, &counter);
+
+        jobs.wait_for_counter(counter);
+
+        REQUIRE(run_count == 1000);
+    }
+
+    SECTION("a counter on the stack can be destroyed as soon as a wait on it returns")
+    {
+        std::atomic<int> run_count(0);
+
+        // the last decrement must be done with the counter by the time the waiter sees it reach zero
+        for (int i(0); i < 2000; ++i)
+        {
+            jfc::fiber_job_system::counter counter;
+
+            jobs.run_jobs([&run_count]() { run_count.fetch_add(1); }, &counter);
+
+            jobs.wait_for_counter(counter);
+        }
+
+        REQUIRE(run_count == 2000);
+    }
+}
+
+#endif
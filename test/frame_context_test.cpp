@@ -0,0 +1,118 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/frame_context.h>
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+TEST_CASE( "jfc::frame_context test", "[jfc::frame_context]" )
+{
+    jfc::thread_group group(4);
+
+    jfc::frame_context frame(group, 64 * 1024);
+
+    SECTION("end_frame completes the frame's tasks and resets the arena")
+    {
+        for (int frame_index(0); frame_index < 10; ++frame_index)
+        {
+            auto results = frame.allocate<int>(100);
+
+            for (int i(0); i < 100; ++i) frame.add_task([results, i]()
+            {
+                results[i] = i * i;
+            });
+
+            REQUIRE(frame.bytes_used() > 0);
+
+            frame.end_frame();
+
+            REQUIRE(frame.outstanding_task_count() == 0);
+            REQUIRE(frame.bytes_used() == 0);
+
+            for (int i(0); i < 100; ++i) REQUIRE(results[i] == i * i);
+        }
+    }
+
+    SECTION("tasks may add tasks and allocate during the frame, closures are destroyed once run")
+    {
+        auto resource = std::make_shared<int>(0);
+
+        std::atomic<int> child_count(0);
+
+        for (int i(0); i < 10; ++i) frame.add_task([&frame, &child_count, resource]()
+        {
+            auto storage = frame.allocate<double>(4);
+
+            frame.add_task([&child_count, storage]()
+            {
+                storage[0] = 1;
+
+                child_count.fetch_add(1);
+            });
+        });
+
+        frame.end_frame();
+
+        REQUIRE(child_count == 10);
+        REQUIRE(resource.use_count() == 1);
+    }
+
+    SECTION("adding tasks does not allocate once the group's queue has grown")
+    {
+        static constexpr int TASK_COUNT = 64;
+
+        // paused, so that only this thread touches the queue while allocations are counted
+        group.pause();
+
+        int results[TASK_COUNT] = {};
+
+        // the first frame grows the queue's storage for this producer, the second reuses it
+        for (int frame_index(0); frame_index < 2; ++frame_index)
+        {
+            const auto allocations_before = jfc_test::allocation_count();
+
+            for (int i(0); i < TASK_COUNT; ++i) frame.add_task([&results, i, frame_index]()
+            {
+                results[i] = i + frame_index;
+            });
+
+            if (frame_index) REQUIRE(jfc_test::allocation_count() == allocations_before);
+
+            frame.end_frame();
+        }
+
+        group.resume();
+
+        for (int i(0); i < TASK_COUNT; ++i) REQUIRE(results[i] == i + 1);
+    }
+
+    SECTION("a task that throws still completes, and its closure is destroyed")
+    {
+        jfc::thread_group inline_group(0);
+
+        jfc::frame_context inline_frame(inline_group, 1024);
+
+        auto resource = std::make_shared<int>(0);
+
+        inline_frame.add_task([resource]() { throw std::runtime_error("failed on purpose"); });
+
+        REQUIRE_THROWS_AS(inline_frame.end_frame(), std::runtime_error);
+        REQUIRE(inline_frame.outstanding_task_count() == 0);
+        REQUIRE(resource.use_count() == 1);
+
+        inline_frame.end_frame();
+
+        REQUIRE(inline_frame.bytes_used() == 0);
+    }
+
+    SECTION("exhausting the arena throws")
+    {
+        REQUIRE_THROWS_AS(frame.allocate<char>(frame.capacity() + 1), std::bad_alloc);
+    }
+}
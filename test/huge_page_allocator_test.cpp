@@ -0,0 +1,74 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/huge_page_allocator.h>
+
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+TEST_CASE( "jfc::huge_page_allocator test", "[jfc::huge_page_allocator]" )
+{
+    static constexpr size_t HUGE_PAGE_SIZE = jfc::huge_page_region::HUGE_PAGE_SIZE;
+
+    SECTION("regions are whole, aligned huge pages of zeroed memory")
+    {
+        jfc::huge_page_region region(HUGE_PAGE_SIZE + 1);
+
+        REQUIRE(region.size() == 2 * HUGE_PAGE_SIZE);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(region.data()) % HUGE_PAGE_SIZE == 0);
+
+        const auto bytes = static_cast<unsigned char *>(region.data());
+
+        REQUIRE(bytes[0] == 0);
+        REQUIRE(bytes[region.size() - 1] == 0);
+
+        std::memset(bytes, 0xff, region.size());
+
+        REQUIRE(jfc::huge_page_region(0).size() == HUGE_PAGE_SIZE);
+    }
+
+    SECTION("the arena bumps through a region, then grows by another")
+    {
+        jfc::huge_page_arena arena;
+
+        REQUIRE(arena.capacity() == 0);
+        REQUIRE(arena.backing() == jfc::huge_page_region::backing_type::normal_pages);
+
+        const auto a = static_cast<unsigned char *>(arena.try_allocate(100));
+        const auto b = static_cast<unsigned char *>(arena.try_allocate(8, 64));
+
+        REQUIRE(a);
+        REQUIRE(b);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+        REQUIRE(b >= a + 100);
+        REQUIRE(b < a + 100 + 64);
+        REQUIRE(arena.capacity() == HUGE_PAGE_SIZE);
+
+        // too large for what is left of the first region
+        const auto c = static_cast<unsigned char *>(arena.try_allocate(HUGE_PAGE_SIZE));
+
+        REQUIRE(c);
+        REQUIRE(reinterpret_cast<std::uintptr_t>(c) % HUGE_PAGE_SIZE == 0);
+        REQUIRE(arena.capacity() == 2 * HUGE_PAGE_SIZE);
+
+        std::memset(c, 1, HUGE_PAGE_SIZE);
+    }
+
+    SECTION("containers can be backed by an arena")
+    {
+        jfc::huge_page_arena arena;
+
+        std::vector<int, jfc::huge_page_allocator<int>> values(1000, 0, jfc::huge_page_allocator<int>(&arena));
+
+        std::iota(values.begin(), values.end(), 0);
+
+        values.resize(100000);
+
+        REQUIRE(values[999] == 999);
+        REQUIRE(values.get_allocator() == jfc::huge_page_allocator<long>(&arena));
+        REQUIRE(arena.capacity() >= values.size() * sizeof(int));
+    }
+}
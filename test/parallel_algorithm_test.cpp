@@ -0,0 +1,121 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/parallel_algorithm.h>
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST_CASE( "jfc::execution::par_on test", "[jfc::execution::par_on]" )
+{
+    jfc::thread_group group(3);
+
+    const auto policy = jfc::execution::par_on(group);
+
+    std::vector<int> values(10007);
+
+    std::iota(values.begin(), values.end(), 0);
+
+    SECTION("for_each, fill and copy visit every element exactly once")
+    {
+        std::vector<std::atomic<int>> visits(values.size());
+
+        for_each(policy, values.begin(), values.end(), [&visits](const int value) { visits[value].fetch_add(1); });
+
+        REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &count) { return count.load() == 1; }));
+
+        std::vector<int> copied(values.size());
+
+        REQUIRE(copy(policy, values.begin(), values.end(), copied.begin()) == copied.end());
+        REQUIRE(copied == values);
+
+        fill(policy.with_grain_size(1000), copied.begin(), copied.end(), 7);
+
+        REQUIRE(std::all_of(copied.begin(), copied.end(), [](const int value) { return value == 7; }));
+    }
+
+    SECTION("transform and reduce match their sequential counterparts")
+    {
+        std::vector<long long> squares(values.size());
+
+        transform(policy, values.begin(), values.end(), squares.begin(), [](const int value) { return static_cast<long long>(value) * value; });
+
+        std::vector<long long> sums(values.size());
+
+        transform(policy, values.begin(), values.end(), squares.begin(), sums.begin(), [](const int a, const long long b) { return a + b; });
+
+        REQUIRE(reduce(policy, squares.begin(), squares.end(), 0LL) == std::accumulate(squares.begin(), squares.end(), 0LL));
+        REQUIRE(reduce(policy, sums.begin(), sums.end()) == std::accumulate(sums.begin(), sums.end(), 0LL));
+        REQUIRE(reduce(policy, values.begin(), values.begin(), 5) == 5);
+
+        // order is preserved, so associative but non commutative operations give the sequential result
+        std::vector<std::string> letters;
+
+        for (char c('a'); c <= 'z'; ++c) letters.emplace_back(1, c);
+
+        REQUIRE(reduce(policy, letters.begin(), letters.end(), std::string(">")) == ">abcdefghijklmnopqrstuvwxyz");
+    }
+
+    SECTION("sort orders the range for any number of chunks")
+    {
+        std::mt19937 random(42);
+
+        for (const size_t grain : {1, 7, 100, 5000, 20000})
+        {
+            auto shuffled = values;
+
+            std::shuffle(shuffled.begin(), shuffled.end(), random);
+
+            sort(policy.with_grain_size(grain), shuffled.begin(), shuffled.end());
+
+            REQUIRE(shuffled == values);
+        }
+
+        auto descending = values;
+
+        sort(policy, descending.begin(), descending.end(), std::greater<>());
+
+        REQUIRE(std::is_sorted(descending.begin(), descending.end(), std::greater<>()));
+    }
+
+    SECTION("the first exception is rethrown once every chunk has run")
+    {
+        std::atomic<size_t> visited(0);
+
+        REQUIRE_THROWS_AS(for_each(policy, values.begin(), values.end(), [&visited](const int value)
+        {
+            ++visited;
+
+            if (value == 5000) throw std::runtime_error("element failed");
+        }), std::runtime_error);
+
+        // the throwing chunk stops at 5000, the others run to completion
+        REQUIRE(visited > 5000);
+        REQUIRE(visited < values.size());
+        REQUIRE(group.try_get_task() == std::nullopt);
+    }
+
+    SECTION("groups without threads and ranges without random access run on the calling thread")
+    {
+        jfc::thread_group empty_group(0);
+
+        auto copied = values;
+
+        std::reverse(copied.begin(), copied.end());
+
+        sort(jfc::execution::par_on(empty_group), copied.begin(), copied.end());
+
+        REQUIRE(copied == values);
+
+        std::list<int> list(values.begin(), values.end());
+
+        REQUIRE(reduce(policy, list.begin(), list.end(), 0LL) == std::accumulate(values.begin(), values.end(), 0LL));
+    }
+}
@@ -0,0 +1,210 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/remote_execution.h>
+
+#ifdef JFC_REMOTE_EXECUTION_SUPPORTED
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+    const jfc::remote_function<int(int)> square("square");
+
+    const jfc::remote_function<std::string(std::string)> reverse("reverse");
+
+    const jfc::remote_function<int(int)> fail("fail");
+
+    const jfc::remote_function<int(int)> sleep_for_ms("sleep_for_ms");
+
+    const jfc::remote_function<int(int)> unregistered("unregistered");
+
+    const jfc::remote_function<int(int)> count_call("count_call");
+
+    jfc::remote_function_registry make_registry()
+    {
+        jfc::remote_function_registry registry;
+
+        registry.add(square, [](const int x) { return x * x; });
+        registry.add(reverse, [](const std::string &s) { return std::string(s.rbegin(), s.rend()); });
+        registry.add(fail, [](int) -> int { throw std::logic_error("failed on purpose"); });
+        registry.add(sleep_for_ms, [](const int ms)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+
+            return ms;
+        });
+
+        return registry;
+    }
+}
+
+TEST_CASE( "jfc::remote_executor test", "[jfc::remote_executor]" )
+{
+    const auto path = "/tmp/jfc-remote_execution_test-" + std::to_string(::getpid());
+
+    jfc::thread_group group(2);
+
+    jfc::remote_worker worker(group, make_registry(), path);
+
+    SECTION("calls return the remote function's result")
+    {
+        jfc::remote_executor executor(path);
+
+        REQUIRE(executor.submit(square, 7).get() == 49);
+        REQUIRE(executor.submit(reverse, std::string("abc")).get() == "cba");
+    }
+
+    SECTION("many concurrent calls are batched and all complete")
+    {
+        jfc::remote_executor executor(path, {64, 16});
+
+        std::vector<std::future<int>> results;
+
+        for (int i(0); i < 2000; ++i) results.push_back(executor.submit(square, i));
+
+        for (int i(0); i < 2000; ++i) REQUIRE(results[i].get() == i * i);
+
+        REQUIRE(executor.in_flight_count() == 0);
+        REQUIRE(worker.completed_request_count() >= 2000);
+    }
+
+    SECTION("the window limits the calls awaiting results")
+    {
+        jfc::remote_executor executor(path, {2, 16});
+
+        auto first = executor.submit(sleep_for_ms, 50);
+        auto second = executor.submit(sleep_for_ms, 50);
+
+        REQUIRE(executor.in_flight_count() == 2);
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        // blocks until a result returns credit
+        auto third = executor.submit(square, 3);
+
+        REQUIRE(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(20));
+        REQUIRE(executor.in_flight_count() <= 2);
+        REQUIRE(third.get() == 9);
+    }
+
+    SECTION("remote exceptions and unknown functions are reported through the future")
+    {
+        jfc::remote_executor executor(path);
+
+        REQUIRE_THROWS_AS(executor.submit(fail, 1).get(), std::runtime_error);
+        REQUIRE_THROWS_AS(executor.submit(unregistered, 1).get(), std::runtime_error);
+
+        // the connection survives failed calls
+        REQUIRE(executor.submit(square, 2).get() == 4);
+    }
+
+    SECTION("several clients share a worker")
+    {
+        std::vector<std::thread> clients;
+
+        std::atomic<int> correct(0);
+
+        for (int c(0); c < 4; ++c) clients.emplace_back([&, c]()
+        {
+            jfc::remote_executor executor(path);
+
+            for (int i(0); i < 100; ++i) if (executor.submit(square, c * 100 + i).get() == (c * 100 + i) * (c * 100 + i)) ++correct;
+        });
+
+        for (auto &client : clients) client.join();
+
+        REQUIRE(correct.load() == 400);
+    }
+
+    SECTION("calls pending when the executor is destroyed fail")
+    {
+        std::future<int> pending;
+
+        {
+            jfc::remote_executor executor(path);
+
+            pending = executor.submit(sleep_for_ms, 100);
+        }
+
+        REQUIRE_THROWS_AS(pending.get(), std::runtime_error);
+    }
+
+    SECTION("calls larger together than a frame are split across frames, a single oversized argument is rejected")
+    {
+        // a window of one holds the worker's reader back behind the first call, so the socket fills and the client's calls queue up into one batch
+        jfc::remote_worker narrow_worker(group, make_registry(), path + "-frames", jfc::remote_worker::options_type{1});
+
+        jfc::remote_executor executor(path + "-frames");
+
+        const std::string large(jfc::remote_executor::MAX_PAYLOAD_SIZE / 3, 'a');
+
+        auto first = executor.submit(sleep_for_ms, 100);
+
+        std::vector<std::future<std::string>> results;
+
+        for (int i(0); i < 8; ++i) results.push_back(executor.submit(reverse, large));
+
+        REQUIRE(first.get() == 100);
+
+        for (auto &result : results) REQUIRE(result.get().size() == large.size());
+
+        REQUIRE_THROWS_AS(executor.submit(reverse, std::string(jfc::remote_executor::MAX_PAYLOAD_SIZE + 1, 'a')), std::invalid_argument);
+        REQUIRE(executor.in_flight_count() == 0);
+
+        // the connection survives the rejected call
+        REQUIRE(executor.submit(square, 3).get() == 9);
+    }
+
+    SECTION("a worker destroyed while a connection waits for its window takes no further requests")
+    {
+        std::atomic<int> counted_calls(0);
+
+        auto registry = make_registry();
+
+        registry.add(count_call, [&counted_calls](const int x) { return counted_calls.fetch_add(1) + x; });
+
+        auto pNarrowWorker = std::make_unique<jfc::remote_worker>(group, std::move(registry), path + "-narrow", jfc::remote_worker::options_type{1});
+
+        jfc::remote_executor executor(path + "-narrow");
+
+        auto running = executor.submit(sleep_for_ms, 100);
+        auto held_back = executor.submit(count_call, 0);
+
+        // lets the worker read both calls, so that it holds the second back while the first runs
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+
+        pNarrowWorker.reset();
+
+        REQUIRE(counted_calls == 0);
+        REQUIRE_THROWS_AS(held_back.get(), std::runtime_error);
+    }
+
+    SECTION("connecting to a missing socket, or binding a taken one, throws")
+    {
+        REQUIRE_THROWS_AS(jfc::remote_executor(path + "-missing"), std::system_error);
+        REQUIRE_THROWS_AS(jfc::remote_worker(group, make_registry(), path), std::system_error);
+    }
+
+    SECTION("a function id may only be registered once")
+    {
+        jfc::remote_function_registry registry;
+
+        registry.add(square, [](const int x) { return x; });
+
+        REQUIRE_THROWS_AS(registry.add(square, [](const int x) { return x; }), std::invalid_argument);
+    }
+}
+
+#endif
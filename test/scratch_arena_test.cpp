@@ -0,0 +1,157 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/scratch_arena.h>
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+template<class T>
+using scratch_vector = std::vector<T, jfc::scratch_allocator<T>>;
+
+TEST_CASE( "jfc::scratch_arena test", "[jfc::scratch_arena]" )
+{
+    SECTION("each task sees its worker's arena, reset after the previous task")
+    {
+        jfc::thread_group group(1);
+
+        std::atomic<int> remaining(2);
+
+        jfc::scratch_arena *pFirstArena(nullptr), *pSecondArena(nullptr);
+
+        size_t used_during_first(0), used_at_start_of_second(1);
+
+        int sum(0);
+
+        group.add_tasks([&]()
+        {
+            pFirstArena = jfc::scratch_arena::current();
+
+            scratch_vector<int> values(1000);
+
+            std::iota(values.begin(), values.end(), 0);
+
+            sum = std::accumulate(values.begin(), values.end(), 0);
+
+            used_during_first = pFirstArena->bytes_used();
+
+            --remaining;
+        });
+
+        group.add_tasks([&]()
+        {
+            pSecondArena = jfc::scratch_arena::current();
+
+            used_at_start_of_second = pSecondArena->bytes_used();
+
+            --remaining;
+        });
+
+        while (remaining) std::this_thread::yield();
+
+        REQUIRE(pFirstArena);
+        REQUIRE(pFirstArena == pSecondArena);
+        REQUIRE(used_during_first >= 1000 * sizeof(int));
+        REQUIRE(used_at_start_of_second == 0);
+        REQUIRE(sum == 999 * 1000 / 2);
+    }
+
+    SECTION("threads without an arena, and full arenas, fall back to the heap")
+    {
+        REQUIRE(!jfc::scratch_arena::current());
+
+        scratch_vector<int> heap_values(100, 1);
+
+        REQUIRE(!heap_values.get_allocator().arena());
+
+        jfc::scratch_arena arena(256);
+
+        {
+            jfc::scratch_arena::current_scope scope(&arena);
+
+            REQUIRE(jfc::scratch_arena::current() == &arena);
+
+            scratch_vector<char> small(100);
+
+            REQUIRE(arena.owns(small.data()));
+
+            scratch_vector<char> large(1000);
+
+            REQUIRE(!arena.owns(large.data()));
+        }
+
+        REQUIRE(!jfc::scratch_arena::current());
+    }
+
+    SECTION("the most recent allocation is returned to the arena when freed")
+    {
+        jfc::scratch_arena arena(4096);
+
+        jfc::scratch_allocator<int> allocator(&arena);
+
+        auto p = allocator.allocate(16);
+
+        REQUIRE(arena.bytes_used() == 16 * sizeof(int));
+
+        allocator.deallocate(p, 16);
+
+        REQUIRE(arena.bytes_used() == 0);
+
+        auto a = allocator.allocate(4);
+        auto b = allocator.allocate(4);
+
+        // not the most recent, so left for reset
+        allocator.deallocate(a, 4);
+
+        REQUIRE(arena.bytes_used() == 8 * sizeof(int));
+
+        allocator.deallocate(b, 4);
+
+        arena.reset();
+
+        REQUIRE(arena.bytes_used() == 0);
+
+        REQUIRE(jfc::scratch_allocator<char>(allocator) == allocator);
+        REQUIRE(jfc::scratch_allocator<int>() != allocator);
+    }
+
+    SECTION("a growing vector keeps its old buffers until reset, and returns its last one when destroyed")
+    {
+        jfc::scratch_arena arena(64 * 1024);
+
+        size_t buffer_bytes(0), last_buffer_bytes(0);
+
+        {
+            scratch_vector<int> values{jfc::scratch_allocator<int>(&arena)};
+
+            for (int i(0); i < 1000; ++i)
+            {
+                const auto capacity = values.capacity();
+
+                values.push_back(i);
+
+                if (values.capacity() != capacity)
+                {
+                    last_buffer_bytes = values.capacity() * sizeof(int);
+
+                    buffer_bytes += last_buffer_bytes;
+                }
+            }
+
+            REQUIRE(arena.owns(values.data()));
+
+            // each new buffer was allocated while the old one was live, so none was returned
+            REQUIRE(arena.bytes_used() == buffer_bytes);
+        }
+
+        REQUIRE(arena.bytes_used() == buffer_bytes - last_buffer_bytes);
+
+        arena.reset();
+
+        REQUIRE(arena.bytes_used() == 0);
+    }
+}
@@ -0,0 +1,184 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/shared_memory_queue.h>
+
+#ifdef JFC_SHARED_MEMORY_SUPPORTED
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST_CASE( "jfc::shared_memory_queue test", "[jfc::shared_memory_queue]" )
+{
+    using queue_type = jfc::shared_memory_queue<int, 64>;
+
+    const auto name = "/jfc-shared_memory_queue_test-" + std::to_string(::getpid());
+
+    queue_type creator(name, jfc::shared_memory_region::open_mode::create);
+
+    SECTION("items added through one mapping are taken through another")
+    {
+        // a second mapping of the same object lies at a different address, as in another process
+        queue_type opener(name, jfc::shared_memory_region::open_mode::open);
+
+        REQUIRE(creator.try_enqueue(1));
+        REQUIRE(creator.try_enqueue(2));
+
+        int item = 0;
+
+        REQUIRE(opener.try_dequeue(item));
+        REQUIRE(item == 1);
+        REQUIRE(opener.try_dequeue(item));
+        REQUIRE(item == 2);
+        REQUIRE(!opener.try_dequeue(item));
+    }
+
+    SECTION("a full queue rejects items until one is taken")
+    {
+        for (int i(0); i < static_cast<int>(queue_type::capacity()); ++i) REQUIRE(creator.try_enqueue(i));
+
+        REQUIRE(!creator.try_enqueue(-1));
+
+        int item;
+
+        REQUIRE(creator.try_dequeue(item));
+        REQUIRE(creator.try_enqueue(-1));
+    }
+
+    SECTION("creating a name that is taken, or opening one that is not, throws")
+    {
+        REQUIRE_THROWS_AS(queue_type(name, jfc::shared_memory_region::open_mode::create), std::system_error);
+        REQUIRE_THROWS_AS(queue_type(name + "-missing", jfc::shared_memory_region::open_mode::open), std::system_error);
+    }
+
+    SECTION("a blocked dequeue is woken by an enqueue, and close releases blocked consumers")
+    {
+        std::atomic<int> received(0);
+
+        std::thread consumer([&]()
+        {
+            queue_type opener(name, jfc::shared_memory_region::open_mode::open);
+
+            int item;
+
+            while (opener.dequeue(item)) received += item;
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        REQUIRE(creator.enqueue(5));
+
+        while (received.load() != 5) std::this_thread::yield();
+
+        creator.close();
+
+        consumer.join();
+
+        REQUIRE(creator.is_closed());
+        REQUIRE(!creator.enqueue(1));
+    }
+
+    SECTION("a thread_group consumes items produced by another process")
+    {
+        static constexpr int COUNT = 1000;
+
+        const auto child = ::fork();
+
+        REQUIRE(child >= 0);
+
+        if (!child)
+        {
+            queue_type opener(name, jfc::shared_memory_region::open_mode::open);
+
+            for (int i(1); i <= COUNT; ++i) opener.enqueue(i);
+
+            ::_exit(0);
+        }
+
+        std::atomic<long> sum(0);
+
+        std::atomic<int> count(0);
+
+        {
+            jfc::thread_group group(2);
+
+            creator.consume(group, [&](const int item)
+            {
+                sum += item;
+
+                if (++count == COUNT) creator.close();
+            });
+        }
+
+        int status = 0;
+
+        ::waitpid(child, &status, 0);
+
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(WEXITSTATUS(status) == 0);
+        REQUIRE(count.load() == COUNT);
+        REQUIRE(sum.load() == static_cast<long>(COUNT) * (COUNT + 1) / 2);
+    }
+
+    SECTION("an opener that starts before the creator has sized the object waits for it")
+    {
+        const auto region_name = name + "-region";
+
+        static constexpr size_t REGION_SIZE = 4096;
+
+        // the first half of what a creating region does, leaving the object empty
+        const auto descriptor = ::shm_open(region_name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+
+        REQUIRE(descriptor >= 0);
+
+        std::atomic<size_t> opened_size(0);
+
+        std::thread opener([&]()
+        {
+            try
+            {
+                jfc::shared_memory_region region(region_name, REGION_SIZE, jfc::shared_memory_region::open_mode::open);
+
+                opened_size = region.size();
+            }
+            catch (const std::system_error &) {}
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        REQUIRE(::ftruncate(descriptor, REGION_SIZE) == 0);
+
+        opener.join();
+
+        ::close(descriptor);
+        ::shm_unlink(region_name.c_str());
+
+        REQUIRE(opened_size == REGION_SIZE);
+    }
+
+    SECTION("opening an object smaller than requested throws once the creator has had time to size it")
+    {
+        jfc::shared_memory_region small(name + "-small", 64, jfc::shared_memory_region::open_mode::create);
+
+        REQUIRE_THROWS_AS(jfc::shared_memory_region(name + "-small", 4096, jfc::shared_memory_region::open_mode::open), std::system_error);
+    }
+
+    SECTION("consume requires a group with threads")
+    {
+        jfc::thread_group group(0);
+
+        REQUIRE_THROWS_AS(creator.consume(group, [](int) {}), std::invalid_argument);
+    }
+}
+
+#endif
@@ -0,0 +1,72 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/static_task_graph.h>
+
+#include <atomic>
+
+namespace
+{
+    /// \brief records when it ran, relative to the other nodes
+    struct stamped_node
+    {
+        static std::atomic<int> clock;
+
+        int stamp = -1;
+
+        void operator()() { stamp = clock.fetch_add(1); }
+    };
+
+    std::atomic<int> stamped_node::clock(0);
+
+    struct load : stamped_node {};
+    struct parse : stamped_node {};
+    struct index : stamped_node {};
+    struct save : stamped_node {};
+
+    // declared out of order, to check the order comes from the edges
+    using diamond_graph = jfc::static_task_graph<
+        jfc::dag_node<save, parse, index>,
+        jfc::dag_node<parse, load>,
+        jfc::dag_node<index, load>,
+        jfc::dag_node<load>>;
+
+    static_assert(diamond_graph::node_count() == 4);
+    static_assert(diamond_graph::DEPENDENCY_COUNTS[diamond_graph::index_of<save>()] == 2);
+    static_assert(diamond_graph::DEPENDENCY_COUNTS[diamond_graph::index_of<load>()] == 0);
+    static_assert(diamond_graph::TOPOLOGICAL_ORDER[0] == diamond_graph::index_of<load>());
+    static_assert(diamond_graph::TOPOLOGICAL_ORDER[3] == diamond_graph::index_of<save>());
+}
+
+TEST_CASE( "jfc::static_task_graph test", "[jfc::static_task_graph]" )
+{
+    diamond_graph graph;
+
+    auto require_dependencies_ran_first = [&graph]()
+    {
+        REQUIRE(graph.get<load>().stamp < graph.get<parse>().stamp);
+        REQUIRE(graph.get<load>().stamp < graph.get<index>().stamp);
+        REQUIRE(graph.get<parse>().stamp < graph.get<save>().stamp);
+        REQUIRE(graph.get<index>().stamp < graph.get<save>().stamp);
+    };
+
+    SECTION("running on a group runs each node after its dependencies, repeatedly")
+    {
+        jfc::thread_group group(4);
+
+        for (int i(0); i < 100; ++i)
+        {
+            graph.run(group);
+
+            require_dependencies_ran_first();
+        }
+    }
+
+    SECTION("running sequentially follows the topological order")
+    {
+        graph.run_sequential();
+
+        require_dependencies_ran_first();
+    }
+}
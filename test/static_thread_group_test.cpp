@@ -0,0 +1,58 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/static_thread_group.h>
+
+#include "allocation_counter.h"
+
+#include <atomic>
+#include <set>
+
+TEST_CASE( "jfc::static_thread_group test", "[jfc::static_thread_group]" )
+{
+    SECTION("construction and steady state perform no dynamic allocation")
+    {
+        std::atomic<int> task_count(10000);
+
+        const auto allocations_before = jfc_test::allocation_count();
+
+        {
+            jfc::static_thread_group<4, 256> group;
+
+            for (int i(0); i < 10000; ++i) group.add_task([&task_count]()
+            {
+                task_count.fetch_sub(1, std::memory_order_relaxed);
+            });
+
+            while (task_count > 0) group.try_run_task();
+        }
+
+        REQUIRE(jfc_test::allocation_count() == allocations_before);
+    }
+
+    SECTION("thread ids are recorded for every worker")
+    {
+        jfc::static_thread_group<4, 16> group;
+
+        const auto &ids = group.thread_ids();
+
+        REQUIRE(std::set<std::thread::id>(ids.begin(), ids.end()).size() == 4);
+        REQUIRE(!std::set<std::thread::id>(ids.begin(), ids.end()).count(std::thread::id()));
+    }
+
+    SECTION("a full queue rejects tasks, tasks can be consumed outside the group")
+    {
+        jfc::static_thread_group<0, 8> group;
+
+        int run_count(0);
+
+        for (size_t i(0); i < group.queue_capacity(); ++i) REQUIRE(group.try_add_task([&run_count]() { ++run_count; }));
+
+        REQUIRE(!group.try_add_task([&run_count]() { ++run_count; }));
+
+        while (group.try_run_task());
+
+        REQUIRE(run_count == 8);
+    }
+}
@@ -0,0 +1,223 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/task_trace.h>
+#include <jfc/thread_group.h>
+
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using trace = jfc::task_trace;
+
+TEST_CASE( "jfc::task_trace test", "[jfc::task_trace]" )
+{
+    SECTION("a recorder captures the spawn relations, dependencies and workers of a live group's tasks")
+    {
+        jfc::thread_group group(2);
+
+        auto recorder = std::make_shared<jfc::task_trace_recorder>();
+
+        group.set_trace_recorder(recorder);
+
+        std::atomic<int> done(0);
+
+        std::atomic<jfc::task_trace_recorder::id_type> first_child(0);
+
+        group.add_tasks([&group, &recorder, &done, &first_child]()
+        {
+            group.add_tasks([&recorder, &done, &first_child]()
+            {
+                first_child = *recorder->current_task_id();
+
+                ++done;
+            });
+
+            group.add_tasks([&recorder, &done, &first_child]()
+            {
+                while (!first_child.load()) std::this_thread::yield();
+
+                recorder->record_dependency(first_child);
+
+                ++done;
+            });
+
+            ++done;
+        });
+
+        while (done.load() != 3) std::this_thread::yield();
+
+        group.set_trace_recorder(nullptr);
+
+        group.add_tasks([&done]() { ++done; });
+
+        while (done.load() != 4) std::this_thread::yield();
+
+        // the final on_finish may still be in flight when done is observed
+        while (recorder->trace().records().size() != 3) std::this_thread::yield();
+
+        const auto records = recorder->trace().records();
+
+        REQUIRE(!recorder->current_task_id());
+
+        trace::record_type root{}, dependent{};
+
+        for (const auto &record : records)
+        {
+            if (!record.parent) root = record;
+            else if (!record.dependencies.empty()) dependent = record;
+
+            REQUIRE(record.worker >= 0);
+            REQUIRE(record.worker < 2);
+            REQUIRE(record.submit_time <= record.start_time);
+            REQUIRE(record.start_time <= record.end_time);
+        }
+
+        REQUIRE(root.id != 0);
+        REQUIRE(dependent.parent == root.id);
+        REQUIRE(dependent.dependencies.front() == first_child.load());
+
+        for (const auto &record : records) if (record.id != root.id) REQUIRE(record.parent == root.id);
+    }
+
+    SECTION("tasks run inside another task count as its nested time and name it as their parent's child")
+    {
+        jfc::thread_group group(0);
+
+        auto recorder = std::make_shared<jfc::task_trace_recorder>();
+
+        group.set_trace_recorder(recorder);
+
+        group.add_tasks([&group]()
+        {
+            group.add_tasks([]() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+
+            (*group.try_get_task())();
+        });
+
+        (*group.try_get_task())();
+
+        const auto records = recorder->trace().records();
+
+        REQUIRE(records.size() == 2);
+
+        const auto &child = records[0], &parent = records[1];
+
+        REQUIRE(child.parent == parent.id);
+        REQUIRE(child.worker == -1);
+        REQUIRE(parent.nested_time == child.end_time - child.start_time);
+        REQUIRE(parent.nested_time >= 2000000);
+    }
+
+    SECTION("simulating independent tasks scales with the worker count")
+    {
+        trace::record_collection_type records;
+
+        for (trace::id_type id(1); id <= 8; ++id) records.push_back({id, 0, 0, 0, 0, 100, 0, {}});
+
+        const trace workload(records);
+
+        REQUIRE(workload.simulate(1).makespan == 800);
+        REQUIRE(workload.simulate(2).makespan == 400);
+        REQUIRE(workload.simulate(8).makespan == 100);
+        REQUIRE(workload.simulate(16).makespan == 100);
+
+        REQUIRE(workload.simulate(8).utilisation == Approx(1.0));
+        REQUIRE(workload.simulate(16).utilisation == Approx(0.5));
+
+        REQUIRE_THROWS_AS(workload.simulate(0), std::invalid_argument);
+    }
+
+    SECTION("simulated children are released at their spawn point, and dependents complete after their dependencies")
+    {
+        // 1 spawns 2 and 3 halfway through its 100ns; 4 is submitted externally at 0 and waits on 3
+        const trace workload({
+            {1, 0, 0, 0, 0, 100, 0, {}},
+            {2, 1, 0, 50, 100, 300, 0, {}},
+            {3, 1, 1, 50, 50, 450, 0, {}},
+            {4, 0, 1, 0, 0, 10, 0, {3}}});
+
+        const auto one = workload.simulate(1);
+
+        REQUIRE(one.makespan == 100 + 200 + 400 + 10);
+
+        // 1 and 4 start at 0, 4 runs out at 10 but completes with 3; 2 and 3 start at 50 and 100
+        const auto two = workload.simulate(2);
+
+        REQUIRE(two.makespan == 100 + 400);
+
+        // with two workers, fifo leaves the longest task for last
+        const trace skewed({
+            {1, 0, 0, 0, 0, 100, 0, {}},
+            {2, 0, 0, 0, 0, 100, 0, {}},
+            {3, 0, 0, 0, 0, 200, 0, {}}});
+
+        REQUIRE(skewed.simulate(2, trace::scheduling_policy::fifo).makespan == 300);
+        REQUIRE(skewed.simulate(2, trace::scheduling_policy::lifo).makespan == 200);
+        REQUIRE(skewed.simulate(2, trace::scheduling_policy::longest_first).makespan == 200);
+    }
+
+    SECTION("the critical path follows the chain of spawns and dependencies that finishes last")
+    {
+        // 1 spawns 2 and 3 at its start; 4 is submitted externally and waits on 3; 5 is a short independent task
+        const trace workload({
+            {1, 0, 0, 0, 0, 100, 0, {}},
+            {2, 1, 0, 0, 100, 150, 0, {}},
+            {3, 1, 1, 0, 0, 300, 0, {}},
+            {4, 0, 1, 0, 300, 310, 0, {3}},
+            {5, 0, 0, 0, 150, 160, 0, {}}});
+
+        const auto path = workload.critical_path();
+
+        REQUIRE(path.work == 100 + 50 + 300 + 10 + 10);
+        REQUIRE(path.span == 300);
+        REQUIRE(path.parallelism == Approx(470.0 / 300));
+        REQUIRE(path.tasks == std::vector<trace::id_type>{1, 3, 4});
+
+        std::stringstream report;
+
+        workload.print_report(report, 1);
+
+        REQUIRE(report.str().find("parallelism:         1.57") != std::string::npos);
+        REQUIRE(report.str().find("longest critical tasks") != std::string::npos);
+
+        REQUIRE(trace().critical_path().tasks.empty());
+    }
+
+    SECTION("cyclic dependencies are rejected")
+    {
+        const trace cyclic({
+            {1, 0, 0, 0, 0, 10, 0, {2}},
+            {2, 0, 0, 0, 10, 20, 0, {1}}});
+
+        REQUIRE_THROWS_AS(cyclic.simulate(1), std::runtime_error);
+        REQUIRE_THROWS_AS(cyclic.critical_path(), std::runtime_error);
+    }
+
+    SECTION("traces survive a write and read")
+    {
+        const trace original({
+            {1, 0, 3, 5, 10, 100, 20, {}},
+            {2, 1, -1, 50, 60, 70, 0, {1, 7}}});
+
+        std::stringstream stream;
+
+        original.write(stream);
+
+        const auto copy = trace::read(stream);
+
+        REQUIRE(copy.records().size() == 2);
+        REQUIRE(copy.records()[0].worker == 3);
+        REQUIRE(copy.records()[0].nested_time == 20);
+        REQUIRE(copy.records()[1].worker == -1);
+        REQUIRE(copy.records()[1].dependencies == std::vector<trace::id_type>{1, 7});
+        REQUIRE(copy.recorded_makespan() == original.recorded_makespan());
+
+        std::stringstream garbage("not a trace\n");
+
+        REQUIRE_THROWS_AS(trace::read(garbage), std::runtime_error);
+    }
+}
@@ -0,0 +1,101 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/thread_count_calibration.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+/// \brief a workload whose run time depends only on the group size, taking least time at 3 threads and half as long again at 2
+static void synthetic_workload(jfc::thread_group &group)
+{
+    static constexpr int MILLISECONDS[] = {0, 16, 6, 4, 8, 12, 16};
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(MILLISECONDS[group.thread_count()]));
+}
+
+TEST_CASE( "jfc::calibrate_thread_count test", "[jfc::calibrate_thread_count]" )
+{
+    jfc::calibration_options_type options;
+
+    options.thread_counts = {6, 1, 2, 3, 4, 3};
+    options.repetitions = 2;
+
+    SECTION("the smallest group within the tolerance of the fastest is chosen")
+    {
+        options.tolerance = 0;
+
+        REQUIRE(jfc::calibrate_thread_count(synthetic_workload, options) == 3);
+
+        options.tolerance = 0.75;
+
+        REQUIRE(jfc::calibrate_thread_count(synthetic_workload, options) == 2);
+    }
+
+    SECTION("each candidate size gets a fresh group of that size, warmed up before it is timed")
+    {
+        std::vector<size_t> sizes;
+
+        options.thread_counts = {2, 1};
+
+        jfc::calibrate_thread_count([&sizes](jfc::thread_group &group) { sizes.push_back(group.thread_count()); }, options);
+
+        REQUIRE(sizes == std::vector<size_t>{1, 1, 1, 2, 2, 2});
+    }
+
+    SECTION("results are cached per key and reused without running the workload")
+    {
+        const std::string path("jfc_thread_count_calibration_test.cache");
+
+        std::remove(path.c_str());
+
+        options.tolerance = 0;
+        options.cache_path = path;
+        options.cache_key = "synthetic";
+
+        REQUIRE(jfc::calibrate_thread_count(synthetic_workload, options) == 3);
+
+        const auto must_not_run = [](jfc::thread_group &) { throw std::logic_error("workload should not run"); };
+
+        REQUIRE(jfc::calibrate_thread_count(must_not_run, options) == 3);
+
+        options.cache_key = "other";
+        options.thread_counts = {1};
+
+        REQUIRE(jfc::calibrate_thread_count([](jfc::thread_group &) {}, options) == 1);
+
+        // both keys are kept
+        options.cache_key = "synthetic";
+
+        REQUIRE(jfc::calibrate_thread_count(must_not_run, options) == 3);
+
+        std::ifstream file(path);
+
+        size_t lines(0);
+
+        for (std::string line; std::getline(file, line);) ++lines;
+
+        REQUIRE(lines == 2);
+
+        std::remove(path.c_str());
+    }
+
+    SECTION("invalid options are rejected")
+    {
+        const auto nothing = [](jfc::thread_group &) {};
+
+        options.repetitions = 0;
+
+        REQUIRE_THROWS_AS(jfc::calibrate_thread_count(nothing, options), std::invalid_argument);
+
+        options.repetitions = 1;
+        options.cache_key = "two words";
+
+        REQUIRE_THROWS_AS(jfc::calibrate_thread_count(nothing, options), std::invalid_argument);
+    }
+}
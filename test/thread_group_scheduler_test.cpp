@@ -0,0 +1,146 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/catch.hpp>
+
+#include <jfc/thread_group_scheduler.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace jfc::execution;
+
+TEST_CASE( "jfc::execution::thread_group_scheduler test", "[jfc::execution::thread_group_scheduler]" )
+{
+    jfc::thread_group group(3);
+
+    SECTION("then passes values along the chain")
+    {
+        const auto result = sync_wait(schedule(group)
+            | then([]() { return 20; })
+            | then([](const int value) { return value + 1; })
+            | then([](const int value) { return std::to_string(value * 2); }));
+
+        REQUIRE(result);
+        REQUIRE(std::get<0>(*result) == "42");
+    }
+
+    SECTION("senders not bound to a group complete on the starting thread")
+    {
+        const auto result = sync_wait(just(2, 3) | then([](const int a, const int b) { return a * b; }));
+
+        REQUIRE(std::get<0>(*result) == 6);
+    }
+
+    SECTION("an exception thrown in the chain skips later steps and is rethrown by sync_wait")
+    {
+        bool later_step_ran = false;
+
+        REQUIRE_THROWS_AS(sync_wait(schedule(group)
+            | then([]() -> int { throw std::runtime_error("failed"); })
+            | then([&later_step_ran](int) { later_step_ran = true; })), std::runtime_error);
+
+        REQUIRE(!later_step_ran);
+    }
+
+    SECTION("bulk visits every index once with its predecessor's values, then forwards them")
+    {
+        std::vector<std::atomic<int>> visits(1000);
+
+        const auto result = sync_wait(schedule(group)
+            | then([]() { return 5; })
+            | bulk(visits.size(), [&visits](const size_t i, const int value) { visits[i].fetch_add(value); })
+            | then([](const int value) { return value * 2; }));
+
+        REQUIRE(std::get<0>(*result) == 10);
+        REQUIRE(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &v) { return v.load() == 5; }));
+    }
+
+    SECTION("bulk with an empty shape completes without invoking the functor")
+    {
+        bool invoked = false;
+
+        REQUIRE(sync_wait(bulk(schedule(group), 0, [&invoked](size_t) { invoked = true; })));
+        REQUIRE(!invoked);
+    }
+
+    SECTION("bulk runs every chunk before reporting the first exception")
+    {
+        std::atomic<size_t> visits(0);
+
+        REQUIRE_THROWS_AS(sync_wait(schedule(group) | bulk(100, [&visits](const size_t i)
+        {
+            visits.fetch_add(1);
+
+            if (i == 0) throw std::logic_error("failed");
+        })), std::logic_error);
+
+        // only the rest of the failing chunk is skipped
+        REQUIRE(visits.load() > 1);
+    }
+
+    SECTION("sync_wait may be called from within a task")
+    {
+        std::atomic<int> result(0);
+
+        std::atomic<bool> done(false);
+
+        group.add_tasks([&]()
+        {
+            result = std::get<0>(*sync_wait(schedule(group) | then([]() { return 7; })));
+
+            done = true;
+        });
+
+        while (!done) std::this_thread::yield();
+
+        REQUIRE(result.load() == 7);
+    }
+
+    SECTION("a hand written receiver can be connected and started directly, and completes on a worker")
+    {
+        struct receiver_type
+        {
+            jfc::thread_group *pGroup;
+
+            std::atomic<int> *pValue;
+
+            std::atomic<bool> *pOnWorker;
+
+            void set_value(const int value)
+            {
+                pOnWorker->store(pGroup->current_worker_index().has_value());
+
+                pValue->store(value);
+            }
+
+            void set_error(std::exception_ptr) noexcept { pValue->store(-1); }
+
+            void set_stopped() noexcept { pValue->store(-2); }
+        };
+
+        std::atomic<int> value(0);
+
+        std::atomic<bool> on_worker(false);
+
+        auto operation = connect(schedule(get_scheduler(group)) | then([]() { return 3; }), receiver_type{&group, &value, &on_worker});
+
+        start(operation);
+
+        while (!value.load()) std::this_thread::yield();
+
+        REQUIRE(value.load() == 3);
+        REQUIRE(on_worker.load());
+    }
+
+    SECTION("schedulers compare equal when they share a group")
+    {
+        jfc::thread_group other(1);
+
+        REQUIRE(get_scheduler(group) == get_scheduler(group));
+        REQUIRE(get_scheduler(group) != get_scheduler(other));
+    }
+}
@@ -2,10 +2,28 @@
 
 #include <jfc/catch.hpp>
 
+#include <jfc/scratch_arena.h>
 #include <jfc/thread_group.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 TEST_CASE( "jfc::thread_group test", "[jfc::thread_group]" )
 {
@@ -20,6 +38,79 @@ TEST_CASE( "jfc::thread_group test", "[jfc::thread_group]" )
         REQUIRE(group.thread_count() == expected_group_size);
     }
     
+    SECTION("tenants are served by weighted deficit round robin, regardless of how many tasks each submits")
+    {
+        jfc::thread_group inline_group(0);
+
+        REQUIRE(inline_group.tenant_charging() == jfc::thread_group::tenant_charge_mode::elapsed_time);
+
+        // charged per task, so the order does not depend on how long the tasks take
+        inline_group.set_tenant_charging(jfc::thread_group::tenant_charge_mode::task_count);
+
+        const auto heavy = inline_group.add_tenant(4);
+        const auto light = inline_group.add_tenant(1);
+
+        std::string order;
+
+        inline_group.add_tasks(heavy, {40, [&order]() { order += 'h'; }});
+        inline_group.add_tasks(light, {100, [&order]() { order += 'l'; }});
+
+        while (auto task = inline_group.try_get_task()) (*task)();
+
+        std::string expected_order;
+
+        for (int round(0); round < 10; ++round) expected_order += "hhhhl";
+
+        // once the heavy tenant runs dry, the light one has the group to itself
+        expected_order += std::string(90, 'l');
+
+        REQUIRE(order == expected_order);
+
+        // charged by time, every task still runs
+        inline_group.set_tenant_charging(jfc::thread_group::tenant_charge_mode::elapsed_time);
+
+        order.clear();
+
+        inline_group.add_tasks(heavy, {20, [&order]() { order += 'h'; }});
+        inline_group.add_tasks(light, {20, [&order]() { order += 'l'; }});
+
+        while (auto task = inline_group.try_get_task()) (*task)();
+
+        REQUIRE(std::count(order.begin(), order.end(), 'h') == 20);
+        REQUIRE(std::count(order.begin(), order.end(), 'l') == 20);
+
+        REQUIRE_THROWS_AS(inline_group.add_tenant(0), std::invalid_argument);
+        REQUIRE_THROWS_AS(inline_group.add_tasks(light + 1, []() {}), std::out_of_range);
+    }
+
+    SECTION("deadline tasks run earliest deadline first, expired deadline tasks are dropped")
+    {
+        jfc::thread_group inline_group(0);
+
+        std::vector<int> order;
+
+        size_t missed_count(0);
+
+        inline_group.set_deadline_missed_handler([&missed_count](jfc::thread_group::deadline_type)
+        {
+            ++missed_count;
+        });
+
+        const auto now = jfc::thread_group::clock_type::now();
+
+        inline_group.add_tasks([&order]() { order.push_back(0); });
+        inline_group.add_tasks([&order]() { order.push_back(3); }, now + std::chrono::hours(3));
+        inline_group.add_tasks({2, [&order]() { order.push_back(1); }}, now + std::chrono::hours(1));
+        inline_group.add_tasks([&order]() { order.push_back(-1); }, now - std::chrono::hours(1));
+        inline_group.add_tasks([&order]() { order.push_back(2); }, now + std::chrono::hours(2));
+
+        while (auto task = inline_group.try_get_task()) (*task)();
+
+        REQUIRE(order == std::vector<int>{1, 1, 2, 3, 0});
+        REQUIRE(inline_group.dropped_task_count() == 1);
+        REQUIRE(missed_count == 1);
+    }
+
     const int SIZE(4);
 
     jfc::thread_group group(SIZE);
@@ -48,6 +139,735 @@ TEST_CASE( "jfc::thread_group test", "[jfc::thread_group]" )
         }
     }
 
+    SECTION("external threads can attach to the group as workers until a stop condition is met")
+    {
+        std::atomic<int> task_count(1000);
+
+        std::atomic<bool> indices_valid(true);
+
+        REQUIRE(!group.current_worker_index());
+
+        group.add_tasks({size_t(task_count), [&]()
+        {
+            const auto index = group.current_worker_index();
+
+            if (!index || *index > SIZE) indices_valid = false;
+
+            task_count.fetch_sub(1, std::memory_order_relaxed);
+        }});
+
+        const auto tasks_executed = group.run_as_worker([&task_count]()
+        {
+            return task_count == 0;
+        });
+
+        REQUIRE(indices_valid);
+        REQUIRE(!group.current_worker_index());
+
+        const auto stats = group.worker_stats();
+
+        REQUIRE(stats.size() == SIZE + 1);
+        REQUIRE(stats.back().is_external);
+        REQUIRE(stats.back().worker_index == SIZE);
+        REQUIRE(stats.back().tasks_executed == tasks_executed);
+    }
+
+    SECTION("an external worker that stops after being woken for a task passes the wake-up on")
+    {
+        // repeated since the ordering below makes the external worker the one woken only when its park outlasts the group worker's
+        for (int trial(0); trial < 20; ++trial)
+        {
+            std::promise<void> release_worker, worker_blocked, task_ran;
+
+            std::atomic<bool> stop_external(false);
+
+            jfc::thread_group pair_group(1);
+
+            const auto times_parked = [&pair_group](const size_t workerIndex)
+            {
+                const auto stats = pair_group.worker_stats();
+
+                return workerIndex < stats.size() ? stats[workerIndex].times_parked : 0;
+            };
+
+            pair_group.add_tasks([&worker_blocked, release = release_worker.get_future().share()]()
+            {
+                worker_blocked.set_value();
+
+                release.wait();
+            });
+
+            worker_blocked.get_future().wait();
+
+            std::thread external([&]() { pair_group.run_as_worker([&stop_external]() { return stop_external.load(); }); });
+
+            // the external worker parks first, then the group worker, so the condition variable wakes the external worker first
+            while (!times_parked(1)) std::this_thread::yield();
+
+            const auto worker_parked_before = times_parked(0);
+
+            release_worker.set_value();
+
+            while (times_parked(0) == worker_parked_before) std::this_thread::yield();
+
+            stop_external = true;
+
+            pair_group.add_tasks([&task_ran]() { task_ran.set_value(); });
+
+            const auto status = task_ran.get_future().wait_for(std::chrono::seconds(1));
+
+            external.join();
+
+            REQUIRE(status == std::future_status::ready);
+        }
+    }
+
+    SECTION("broadcast runs a functor exactly once on every thread in the group")
+    {
+        for (const auto mode : {jfc::thread_group::broadcast_mode::independent, jfc::thread_group::broadcast_mode::barrier})
+        {
+            std::mutex mutex;
+
+            std::multiset<std::thread::id> ids;
+
+            std::atomic<int> remaining(SIZE);
+
+            group.broadcast([&]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    ids.insert(std::this_thread::get_id());
+                }
+
+                remaining.fetch_sub(1);
+            }, mode);
+
+            while (remaining > 0) std::this_thread::yield();
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const auto thread_ids = group.thread_ids();
+
+            REQUIRE(ids == std::multiset<std::thread::id>(thread_ids.begin(), thread_ids.end()));
+        }
+    }
+
+    SECTION("barrier broadcasts from several threads run in the same order on every thread")
+    {
+        static constexpr int BROADCASTS_PER_THREAD = 50;
+
+        std::mutex mutex;
+
+        std::map<std::thread::id, std::vector<int>> orders;
+
+        std::atomic<int> remaining(2 * BROADCASTS_PER_THREAD * SIZE);
+
+        std::promise<void> all_run;
+
+        const auto broadcast_from = [&](const int first_id)
+        {
+            for (int id(first_id); id < first_id + BROADCASTS_PER_THREAD; ++id) group.broadcast([&, id]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    orders[std::this_thread::get_id()].push_back(id);
+                }
+
+                if (remaining.fetch_sub(1) == 1) all_run.set_value();
+            }, jfc::thread_group::broadcast_mode::barrier);
+        };
+
+        std::thread other_broadcaster(broadcast_from, BROADCASTS_PER_THREAD);
+
+        broadcast_from(0);
+
+        other_broadcaster.join();
+
+        all_run.get_future().wait();
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        REQUIRE(orders.size() == SIZE);
+
+        for (const auto &order : orders) REQUIRE(order.second == orders.begin()->second);
+    }
+
+    SECTION("a barrier broadcast made while paused completes after resume")
+    {
+        std::atomic<int> run_count(0);
+
+        std::promise<void> all_run;
+
+        group.pause();
+
+        group.broadcast([&]()
+        {
+            if (run_count.fetch_add(1) == SIZE - 1) all_run.set_value();
+        }, jfc::thread_group::broadcast_mode::barrier);
+
+        auto all_run_future = all_run.get_future();
+
+        REQUIRE(all_run_future.wait_for(std::chrono::milliseconds(20)) == std::future_status::timeout);
+
+        group.resume();
+
+        all_run_future.wait();
+
+        REQUIRE(run_count == SIZE);
+    }
+
+    SECTION("targeted tasks run on the specified thread, in submission order per submitting thread")
+    {
+        const auto thread_ids = group.thread_ids();
+
+        for (size_t worker_index(0); worker_index < SIZE; ++worker_index)
+        {
+            std::atomic<int> task_count(100);
+
+            std::atomic<bool> ran_on_target(true), ran_in_order(true);
+
+            int next_task(0);
+
+            for (int i(0); i < 100; ++i) group.add_task_to(worker_index, [&, i]()
+            {
+                if (group.current_worker_index() != worker_index || std::this_thread::get_id() != thread_ids[worker_index]) ran_on_target = false;
+
+                if (next_task++ != i) ran_in_order = false;
+
+                task_count.fetch_sub(1);
+            });
+
+            while (task_count > 0) std::this_thread::yield();
+
+            REQUIRE(ran_on_target);
+            REQUIRE(ran_in_order);
+        }
+
+        REQUIRE_THROWS_AS(group.add_task_to(SIZE, []() {}), std::out_of_range);
+    }
+
+    SECTION("only active workers take shared work, surplus workers still serve their mailbox")
+    {
+        REQUIRE(group.active_worker_count() == SIZE);
+
+        group.set_active_worker_count(1);
+
+        REQUIRE(group.active_worker_count() == 1);
+
+        const auto completed_before = group.completed_task_count();
+
+        std::atomic<int> task_count(200);
+
+        std::atomic<bool> ran_on_active(true);
+
+        for (int i(0); i < 200; ++i) group.add_tasks([&]()
+        {
+            if (group.current_worker_index() != size_t(0)) ran_on_active = false;
+
+            task_count.fetch_sub(1);
+        });
+
+        while (task_count > 0) std::this_thread::yield();
+
+        REQUIRE(ran_on_active);
+
+        std::atomic<bool> mail_delivered(false);
+
+        group.add_task_to(SIZE - 1, [&]() { mail_delivered = true; });
+
+        while (!mail_delivered) std::this_thread::yield();
+
+        // the counters are bumped after each task returns
+        while (group.completed_task_count() < completed_before + 201) std::this_thread::yield();
+
+        group.set_active_worker_count(SIZE);
+
+        std::atomic<int> active_task_count(SIZE);
+
+        group.broadcast([&]() { active_task_count.fetch_sub(1); });
+
+        while (active_task_count > 0) std::this_thread::yield();
+
+        REQUIRE_THROWS_AS(group.set_active_worker_count(SIZE + 1), std::out_of_range);
+    }
+
+    SECTION("a paused group accepts work but runs none of it until resumed")
+    {
+        group.pause();
+
+        REQUIRE(group.is_paused());
+
+        // lets any thread that was between tasks when pause was called reach the pause check
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::atomic<int> ran(0);
+
+        for (int i(0); i < 100; ++i) group.add_tasks([&ran]() { ran.fetch_add(1); });
+
+        group.add_task_to(0, [&ran]() { ran.fetch_add(1); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        REQUIRE(ran.load() == 0);
+
+        group.resume();
+
+        REQUIRE(!group.is_paused());
+
+        while (ran.load() != 101) std::this_thread::yield();
+
+        std::atomic<int> ran_after_destruction(0);
+
+        {
+            jfc::thread_group paused_group(2);
+
+            paused_group.pause();
+
+            for (int i(0); i < 10; ++i) paused_group.add_tasks([&ran_after_destruction]() { ran_after_destruction.fetch_add(1); });
+        }
+
+        REQUIRE(ran_after_destruction.load() == 10);
+    }
+
+    SECTION("inline execution runs added tasks on the submitting thread")
+    {
+        REQUIRE(group.inline_execution() == jfc::thread_group::inline_execution_mode::never);
+
+        jfc::thread_group empty_group(0);
+
+        empty_group.set_inline_execution(jfc::thread_group::inline_execution_mode::when_no_workers);
+
+        REQUIRE(empty_group.inline_execution() == jfc::thread_group::inline_execution_mode::when_no_workers);
+
+        const auto caller = std::this_thread::get_id();
+
+        std::vector<int> order;
+
+        std::vector<jfc::thread_group::task_type> tasks;
+
+        for (int i(0); i < 3; ++i) tasks.push_back([&order, i]() { order.push_back(i); });
+
+        empty_group.add_tasks(std::move(tasks));
+
+        REQUIRE(order == std::vector<int>{0, 1, 2});
+
+        bool ran_on_caller(false);
+
+        empty_group.add_tasks(empty_group.add_tenant(), [&]() { ran_on_caller = std::this_thread::get_id() == caller; });
+
+        REQUIRE(ran_on_caller);
+
+        REQUIRE_THROWS_AS(empty_group.add_tasks(size_t(42), []() {}), std::out_of_range);
+
+        REQUIRE_THROWS_AS(empty_group.add_tasks([]() { throw std::runtime_error("inline"); }), std::runtime_error);
+
+        size_t missed(0);
+
+        empty_group.set_deadline_missed_handler([&missed](jfc::thread_group::deadline_type) { ++missed; });
+
+        bool ran_in_time(false), ran_late(false);
+
+        empty_group.add_tasks([&ran_in_time]() { ran_in_time = true; }, jfc::thread_group::clock_type::now() + std::chrono::hours(1));
+        empty_group.add_tasks([&ran_late]() { ran_late = true; }, jfc::thread_group::clock_type::now() - std::chrono::seconds(1));
+
+        REQUIRE(ran_in_time);
+        REQUIRE(!ran_late);
+        REQUIRE(missed == 1);
+        REQUIRE(empty_group.dropped_task_count() == 1);
+
+        // a group with threads runs inline while none of them take shared work
+        group.set_inline_execution(jfc::thread_group::inline_execution_mode::when_no_workers);
+        group.set_active_worker_count(0);
+
+        ran_on_caller = false;
+
+        group.add_tasks([&]() { ran_on_caller = std::this_thread::get_id() == caller; });
+
+        REQUIRE(ran_on_caller);
+
+        group.set_active_worker_count(SIZE);
+
+        std::promise<std::thread::id> queued_thread;
+
+        group.add_tasks([&queued_thread]() { queued_thread.set_value(std::this_thread::get_id()); });
+
+        REQUIRE(queued_thread.get_future().get() != caller);
+
+        group.set_inline_execution(jfc::thread_group::inline_execution_mode::always);
+
+        ran_on_caller = false;
+
+        group.add_tasks([&]() { ran_on_caller = std::this_thread::get_id() == caller; });
+
+        REQUIRE(ran_on_caller);
+    }
+
+    SECTION("two choices placement runs every task, wherever it is placed")
+    {
+        REQUIRE(group.task_placement() == jfc::thread_group::task_placement_mode::shared_queue);
+
+        group.set_task_placement(jfc::thread_group::task_placement_mode::two_choices);
+
+        REQUIRE(group.task_placement() == jfc::thread_group::task_placement_mode::two_choices);
+
+        // tasks placed in the workers' queues can still be taken from outside the group
+        group.pause();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        size_t taken(0);
+
+        group.add_tasks({100, [&taken]() { ++taken; }});
+
+        for (int i(0); i < 50; ++i) group.add_tasks([&taken]() { ++taken; });
+
+        while (auto task = group.try_get_task()) (*task)();
+
+        REQUIRE(taken == 150);
+
+        group.resume();
+
+        const int PRODUCER_COUNT(3), TASKS_PER_PRODUCER(1000);
+
+        std::atomic<int> task_count(PRODUCER_COUNT * TASKS_PER_PRODUCER * 2);
+
+        std::vector<std::thread> producers;
+
+        for (int i(0); i < PRODUCER_COUNT; ++i) producers.emplace_back([&]()
+        {
+            for (int j(0); j < TASKS_PER_PRODUCER; ++j) group.add_tasks([&task_count]() { task_count.fetch_sub(1); });
+
+            group.add_tasks({size_t(TASKS_PER_PRODUCER), [&task_count]() { task_count.fetch_sub(1); }});
+        });
+
+        for (auto &producer : producers) producer.join();
+
+        while (task_count > 0) std::this_thread::yield();
+
+        // tasks placed before a switch back are still found, including those in the queues of workers made surplus
+        group.pause();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        std::atomic<int> remaining(200);
+
+        group.add_tasks({200, [&remaining]() { remaining.fetch_sub(1); }});
+
+        group.set_task_placement(jfc::thread_group::task_placement_mode::shared_queue);
+        group.set_active_worker_count(1);
+
+        group.resume();
+
+        while (remaining > 0) std::this_thread::yield();
+
+        group.set_active_worker_count(SIZE);
+    }
+
+    SECTION("task sources are pulled lazily until exhausted")
+    {
+        const size_t COUNT(10000);
+
+        std::vector<std::atomic<int>> runs(COUNT);
+
+        std::atomic<size_t> remaining(COUNT * 2);
+
+        group.add_task_source(COUNT, [&](const size_t i)
+        {
+            runs[i].fetch_add(1);
+
+            remaining.fetch_sub(1);
+        }, 64);
+
+        std::atomic<size_t> generated(0);
+
+        // called under the source's lock, so needs no synchronization of its own
+        size_t next(0);
+
+        group.add_task_source([&]() -> std::optional<jfc::thread_group::task_type>
+        {
+            if (next == COUNT) return {};
+
+            ++next;
+
+            generated.fetch_add(1);
+
+            return [&remaining]() { remaining.fetch_sub(1); };
+        }, 16);
+
+        while (remaining > 0) if (auto task = group.try_get_task()) (*task)();
+
+        bool each_index_once(true);
+
+        for (const auto &count : runs) if (count != 1) each_index_once = false;
+
+        REQUIRE(each_index_once);
+        REQUIRE(generated == COUNT);
+
+        // a source that is never exhausted until told to stop
+        std::atomic<bool> stop(false);
+
+        std::atomic<size_t> pulled(0);
+
+        group.add_task_source([&]() -> std::optional<jfc::thread_group::task_type>
+        {
+            if (stop) return {};
+
+            return [&pulled]() { pulled.fetch_add(1); };
+        });
+
+        while (pulled < 1000) std::this_thread::yield();
+
+        stop = true;
+
+        jfc::thread_group empty_group(0);
+
+        empty_group.set_inline_execution(jfc::thread_group::inline_execution_mode::when_no_workers);
+
+        size_t inline_sum(0);
+
+        empty_group.add_task_source(100, [&inline_sum](const size_t i) { inline_sum += i; });
+
+        REQUIRE(inline_sum == 4950);
+
+        REQUIRE_THROWS_AS(group.add_task_source(1, [](size_t) {}, 0), std::invalid_argument);
+    }
+
+    SECTION("external threads can help in place, for a time or until a condition is met")
+    {
+        jfc::thread_group inline_group(0);
+
+        REQUIRE(!inline_group.run_one());
+        REQUIRE(inline_group.try_get_tasks(10).empty());
+
+        std::vector<int> order;
+
+        inline_group.add_tasks({3, [&order]() { order.push_back(1); }});
+        inline_group.add_tasks([&order]() { order.push_back(0); }, jfc::thread_group::clock_type::now() + std::chrono::hours(1));
+
+        auto tasks = inline_group.try_get_tasks(3);
+
+        REQUIRE(tasks.size() == 3);
+
+        for (auto &task : tasks) task();
+
+        REQUIRE(order == std::vector<int>{0, 1, 1});
+
+        {
+            jfc::thread_group busy_group(2);
+
+            // the workers are held in a task each, so that they leave their queues alone
+            std::promise<void> release_workers;
+
+            const auto released = release_workers.get_future().share();
+
+            std::atomic<int> held_count(0);
+
+            for (size_t i(0); i < 2; ++i) busy_group.add_task_to(i, [&held_count, released]()
+            {
+                ++held_count;
+
+                released.wait();
+            });
+
+            while (held_count != 2) std::this_thread::yield();
+
+            std::vector<int> placed_order;
+
+            busy_group.set_task_placement(jfc::thread_group::task_placement_mode::two_choices);
+            busy_group.add_tasks([&placed_order]() { placed_order.push_back(2); });
+
+            busy_group.set_task_placement(jfc::thread_group::task_placement_mode::shared_queue);
+            busy_group.add_tasks([&placed_order]() { placed_order.push_back(1); });
+
+            for (auto &task : busy_group.try_get_tasks(2)) task();
+
+            release_workers.set_value();
+
+            REQUIRE(placed_order == std::vector<int>{1, 2});
+        }
+
+        REQUIRE(inline_group.run_one());
+        REQUIRE(!inline_group.run_one());
+        REQUIRE(order.size() == 4);
+
+        size_t count(0);
+
+        inline_group.add_tasks({100, [&count]() { ++count; }});
+
+        REQUIRE(inline_group.run_until([&count]() { return count == 50; }) == 50);
+
+        const auto start_time(std::chrono::steady_clock::now());
+
+        // runs the remaining tasks, then waits out the rest of the slice
+        REQUIRE(inline_group.run_for(std::chrono::milliseconds(20)) == 50);
+
+        REQUIRE(std::chrono::steady_clock::now() - start_time >= std::chrono::milliseconds(20));
+
+        // a helper sleeping for lack of work is woken by new work
+        std::promise<void> helped;
+
+        std::thread producer([&inline_group, &helped]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+            inline_group.add_tasks([&helped]() { helped.set_value(); });
+        });
+
+        auto helped_future = helped.get_future();
+
+        REQUIRE(inline_group.run_until([&helped_future]()
+        {
+            return helped_future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }) == 1);
+
+        producer.join();
+    }
+
+    SECTION("a group backed by huge pages runs tasks as any other")
+    {
+        jfc::thread_group::memory_attributes_type memory;
+        memory.huge_pages = true;
+
+        jfc::thread_group huge_page_group(2, {}, memory);
+
+        huge_page_group.set_task_placement(jfc::thread_group::task_placement_mode::two_choices);
+
+        const int TASK_COUNT(100000);
+
+        std::atomic<int> task_count(TASK_COUNT + 1);
+
+        std::atomic<bool> has_scratch_arena(true);
+
+        // enough tasks for the queues to grow past their initial blocks
+        huge_page_group.pause();
+
+        for (int i(0); i < TASK_COUNT; ++i) huge_page_group.add_tasks([&]()
+        {
+            const auto pArena = jfc::scratch_arena::current();
+
+            if (pArena && !pArena->try_allocate(1024)) has_scratch_arena = false;
+
+            task_count.fetch_sub(1);
+        });
+
+        huge_page_group.add_task_to(1, [&task_count]() { task_count.fetch_sub(1); });
+
+        huge_page_group.resume();
+
+        while (task_count > 0) huge_page_group.run_one();
+
+        REQUIRE(has_scratch_arena);
+    }
+
+    SECTION("threads are created with the requested attributes")
+    {
+        jfc::thread_group::thread_attributes_type attributes;
+
+        attributes.stack_size = 256 * 1024;
+        attributes.name = "jfc-test-";
+        attributes.nice = 5;
+
+        jfc::thread_group small_group(2, attributes);
+
+        const auto ids = small_group.thread_ids();
+
+        REQUIRE(std::set<std::thread::id>(ids.begin(), ids.end()).size() == 2);
+
+#if defined(__linux__)
+        std::mutex mutex;
+
+        std::set<std::string> names;
+
+        std::atomic<int> remaining(2);
+
+        std::atomic<bool> attributes_applied(true);
+
+        // the test blocks rather than spins while it waits, so that deprioritised threads get to run even on a single core
+        std::promise<void> broadcast_done;
+
+        small_group.broadcast([&]()
+        {
+            pthread_attr_t thread_attributes;
+
+            size_t stack_size = 0;
+
+            pthread_getattr_np(pthread_self(), &thread_attributes);
+            pthread_attr_getstacksize(&thread_attributes, &stack_size);
+            pthread_attr_destroy(&thread_attributes);
+
+            if (stack_size < attributes.stack_size || stack_size > 2 * attributes.stack_size) attributes_applied = false;
+
+            if (getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid))) != 5) attributes_applied = false;
+
+            char name[16] = {};
+
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                names.insert(name);
+            }
+
+            if (remaining.fetch_sub(1) == 1) broadcast_done.set_value();
+        });
+
+        broadcast_done.get_future().wait();
+
+        REQUIRE(attributes_applied);
+        REQUIRE(names == std::set<std::string>{"jfc-test-0", "jfc-test-1"});
+
+        attributes = {};
+        attributes.name = "a-very-long-thread-name";
+        attributes.scheduling_policy = jfc::thread_group::thread_attributes_type::scheduling_policy_type::idle;
+
+        jfc::thread_group idle_group(1, attributes);
+
+        std::promise<int> policy;
+
+        names.clear();
+
+        idle_group.add_task_to(0, [&]()
+        {
+            sched_param parameters;
+
+            int current_policy;
+
+            pthread_getschedparam(pthread_self(), &current_policy, &parameters);
+
+            char name[16] = {};
+
+            pthread_getname_np(pthread_self(), name, sizeof(name));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                names.insert(name);
+            }
+
+            policy.set_value(current_policy);
+        });
+
+        REQUIRE(policy.get_future().get() == SCHED_IDLE);
+
+        // shortened to the kernel's 15 characters, keeping the index
+        REQUIRE(names == std::set<std::string>{"a-very-long-th0"});
+#endif
+
+        attributes = {};
+        attributes.nice = 20;
+
+        REQUIRE_THROWS_AS(jfc::thread_group(1, attributes), std::invalid_argument);
+
+        attributes = {};
+        attributes.scheduling_policy = jfc::thread_group::thread_attributes_type::scheduling_policy_type::fifo;
+        attributes.realtime_priority = 0;
+
+        REQUIRE_THROWS_AS(jfc::thread_group(1, attributes), std::invalid_argument);
+    }
+
     SECTION("move semantics work as expected")
     {
         const auto id_count = group.thread_ids().size();
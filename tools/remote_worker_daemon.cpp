@@ -0,0 +1,97 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/remote_execution.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef JFC_REMOTE_EXECUTION_SUPPORTED
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+/// \brief serves remote_executor clients on a Unix domain socket until interrupted or terminated.
+/// it offers the functions used by the remote execution benchmark:
+/// - "jfc.echo", std::string(std::string): returns its argument
+/// - "jfc.spin_for_us", std::uint32_t(std::uint32_t): busy waits for the given number of microseconds, returning it
+///
+/// applications serve their own functions the same way, by building a jfc::remote_function_registry and constructing a jfc::remote_worker.
+/// usage: remote_worker_daemon <socket path> [threads, default hardware concurrency]. A stale socket at the path is replaced
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <socket path> [threads]\n";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const std::string path(argv[1]);
+
+        const size_t thread_count = argc > 2 ? std::stoul(argv[2]) : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+        // blocked before any thread starts, so that every thread inherits the mask and only sigwait receives them
+        sigset_t signals;
+
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        jfc::remote_function_registry registry;
+
+        registry.add(jfc::remote_function<std::string(std::string)>("jfc.echo"), [](const std::string &s) { return s; });
+
+        registry.add(jfc::remote_function<std::uint32_t(std::uint32_t)>("jfc.spin_for_us"), [](const std::uint32_t us)
+        {
+            const auto end_time(std::chrono::steady_clock::now() + std::chrono::microseconds(us));
+
+            while (std::chrono::steady_clock::now() < end_time);
+
+            return us;
+        });
+
+        ::unlink(path.c_str());
+
+        jfc::thread_group group(thread_count);
+
+        jfc::remote_worker worker(group, std::move(registry), path);
+
+        std::cout << "serving on " << path << " with " << thread_count << " threads\n" << std::flush;
+
+        int signal;
+
+        sigwait(&signals, &signal);
+
+        std::cout << "stopping after " << worker.completed_request_count() << " requests\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "error: " << e.what() << "\n";
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main()
+{
+    std::cerr << "remote execution is not supported on this target\n";
+
+    return EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,74 @@
+// © 2019 Joseph Cameron - All Rights Reserved
+
+#include <jfc/task_trace.h>
+
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+/// \brief replays a trace written by jfc::task_trace::write at a range of worker counts and under each scheduling policy,
+/// printing the predicted makespan, speedup over one worker and utilisation, after the trace's critical path report.
+/// usage: trace_simulator <trace file> [max workers, default 16]
+int main(int argc, char **argv)
+{
+    using policy = jfc::task_trace::scheduling_policy;
+
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <trace file> [max workers]\n";
+
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        std::ifstream file(argv[1]);
+
+        if (!file) throw std::runtime_error(std::string("cannot open ") + argv[1]);
+
+        const auto trace = jfc::task_trace::read(file);
+
+        const size_t max_workers = argc > 2 ? std::stoul(argv[2]) : 16;
+
+        trace.print_report(std::cout);
+
+        std::cout << '\n';
+
+        const std::pair<policy, const char *> policies[] = {
+            {policy::fifo, "fifo"},
+            {policy::lifo, "lifo"},
+            {policy::longest_first, "longest first"}};
+
+        for (const auto &[scheduling_policy, name] : policies)
+        {
+            std::cout << name << '\n'
+                << std::setw(8) << "workers" << std::setw(16) << "makespan (us)" << std::setw(10) << "speedup" << std::setw(14) << "utilisation" << '\n';
+
+            const auto baseline = trace.simulate(1, scheduling_policy).makespan;
+
+            for (size_t workers(1); workers <= max_workers; workers *= 2)
+            {
+                const auto result = trace.simulate(workers, scheduling_policy);
+
+                std::cout << std::fixed << std::setprecision(2)
+                    << std::setw(8) << workers
+                    << std::setw(16) << result.makespan / 1000.0
+                    << std::setw(10) << (result.makespan ? static_cast<double>(baseline) / result.makespan : 0.0)
+                    << std::setw(13) << result.utilisation * 100 << "%\n";
+            }
+
+            std::cout << '\n';
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}